@@ -33,6 +33,8 @@ extern "C" {
 #include "gat_parser.h"
 #include "gat_lexer.h"
 #include "gat_io.h"
+#include "gat_ir.h"
+#include "gat_image.h"
 #include "gat_sysutils.h"
 
 #ifdef __cplusplus
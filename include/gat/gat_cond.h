@@ -0,0 +1,38 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __gat_cond_h__
+#define __gat_cond_h__
+
+#include "gat_types.h"
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gat_cond_reset (gat *ga);
+void gat_parse_cond (gat *ga, int token);
+int gat_skip_line (gat *ga, const char *text, size_t length);
+void gat_end_conds (gat *ga);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__gat_cond_h__ */
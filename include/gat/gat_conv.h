@@ -29,6 +29,8 @@ extern "C" {
 /* conversion functions */
 uint32_t gat_hex_to_num (const char *);
 uint32_t gat_dec_to_num (const char *);
+int gat_decode_num (const char *, size_t, uint32_t *);
+uint8_t gat_num_width (uint32_t);
 uint32_t gat_cnum (const char *);
 #define gat_cbyte(_s) ((uint8_t)(gat_cnum(_s)&0x000000FF))
 #define gat_cdbl(_s) ((uint16_t)(gat_cnum(_s)&0x0000FFFF))
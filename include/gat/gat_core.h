@@ -26,15 +26,30 @@
 extern "C" {
 #endif
 
-void gat_init (gat *ga, gat_arch *arch, gat_dirt *dirt_table, unsigned len_dirt_table, gat_instr *instr_table, unsigned len_instr_table);
+void gat_init (gat *ga, const gat_arch *arch, const gat_dirt *dirt_table, unsigned len_dirt_table, const gat_instr *instr_table, unsigned len_instr_table);
 void gat_set_callback (gat *ga, gat_callback callback, void *context);
+void gat_set_keywords (gat *ga, const gat_kwtable *kw_table);
+void gat_set_engine (gat *ga, int engine);
+void gat_set_stats (gat *ga, int enable);
+void gat_set_max_errors (gat *ga, unsigned max_errors);
+void gat_set_pipeline (gat *ga, unsigned num_threads);
+void gat_set_threads (gat *ga, unsigned num_threads);
+void gat_set_include_dir (gat *ga, const char *dir);
 int gat_engine (gat *ga);
+void gat_close (gat *ga);
+void gat_reset (gat *ga);
 void gat_cleanup (gat *ga);
 void gat_init_pass (gat *ga);
 void gat_print (gat *ga, const char *format, ...);
 void gat_error (gat *ga, int, const char *format, ...);
 void gat_warning (gat *ga, int, const char *format, ...);
 void gat_fatal_error (gat *ga, int, const char *format, ...);
+void gat_stats_mark (gat *ga, uint64_t mark[2]);
+void gat_stats_phase (gat *ga, int phase, const uint64_t mark[2]);
+void gat_stats_heap (gat *ga);
+void gat_stats_add (gat_stats *total, const gat_stats *stats);
+void *gat_grow (gat *ga, void *arr, size_t elem_size, size_t count, 
+                size_t *capacity, size_t init_capacity);
 
 #ifdef __cplusplus
 } /* extern "C" { */
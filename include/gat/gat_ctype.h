@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __gat_ctype_h__
+#define __gat_ctype_h__
+
+#include "gat_types.h"
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* character classes */
+#define GAT_CC_WHITE                0x01    /* GAT_WHITE */
+#define GAT_CC_SYMBOL               0x02    /* GAT_SYMBOLS */
+#define GAT_CC_QUOTE                0x04    /* string quote */
+#define GAT_CC_COMMENT              0x08    /* GAT_COMMENT_CHAR */
+#define GAT_CC_DIGIT                0x10    /* [0-9] */
+#define GAT_CC_XDIGIT               0x20    /* [0-9a-fA-F] */
+#define GAT_CC_ID                   0x40    /* [_a-zA-Z0-9] */
+
+/* characters that end a word token */
+#define GAT_CC_DELIM                (GAT_CC_WHITE | GAT_CC_SYMBOL | GAT_CC_QUOTE | GAT_CC_COMMENT)
+
+/* character class table indexed by unsigned character value */
+extern const uint8_t gat_ctype_table[256];
+
+#define gat_ctype(_c)               (gat_ctype_table[(uint8_t)(_c)])
+#define gat_ctype_is(_c,_cc)        ((gat_ctype(_c) & (_cc)) != 0)
+
+/* scans [head, end) for the first delimiter character. returns end if none. */
+const char *gat_scan_delim (const char *head, const char *end);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__gat_ctype_h__ */
@@ -48,6 +48,13 @@ typedef enum _gat_error_code {
     GAT_ERR_TYPE_MISMATCH,
     GAT_ERR_INVALID_INSTRUCTION,
     GAT_ERR_INVALID_CONVERSION,
+    GAT_ERR_MACRO_NESTING,
+    GAT_ERR_MACRO_TOO_DEEP,
+    GAT_ERR_INCLUDE_FILE,
+    GAT_ERR_INCLUDE_TOO_DEEP,
+    GAT_ERR_COND_NESTING,
+    GAT_ERR_COND_TOO_DEEP,
+    GAT_ERR_INVALID_EXPR,
     
     /* fatal errors */  
     GAT_ERR_OFFSET_OUT_OF_RANGE = GAT_ERR_BASE_FATAL,
@@ -56,9 +63,11 @@ typedef enum _gat_error_code {
     GAT_ERR_FILEIO_FAILED,
     GAT_ERR_INVALID_INPUT_PATH,
     GAT_ERR_INVALID_OUTPUT_PATH,
+    GAT_ERR_TOO_MANY_ERRORS,
 
     /* warnings */
-    GAT_WARN_DATA_TRUNCATATION = GAT_ERR_BASE_WARNING
+    GAT_WARN_DATA_TRUNCATATION = GAT_ERR_BASE_WARNING,
+    GAT_WARN_CODE_OVERLAP
 }gat_error_code;
 
 #endif /* !__gat_err_h__ */
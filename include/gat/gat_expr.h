@@ -0,0 +1,41 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __gat_expr_h__
+#define __gat_expr_h__
+
+#include "gat_types.h"
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gat_expr_init (gat *ga);
+void gat_expr_reset (gat *ga);
+void gat_expr_free (gat *ga);
+int gat_expr_operands (gat *ga, int store);
+int gat_expr_value (gat *ga, unsigned first);
+int gat_expr_eval (gat *ga, unsigned index, int32_t *value);
+int gat_expr_defined (gat *ga, unsigned index);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__gat_expr_h__ */
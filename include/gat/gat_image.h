@@ -0,0 +1,43 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __gat_image_h__
+#define __gat_image_h__
+
+#include "gat_types.h"
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* tests coverage and instruction start bits of an address */
+#define gat_image_covered(_image,_addr) (((_image)->coverage[(_addr) >> 3] >> ((_addr) & 7)) & 1)
+#define gat_image_is_start(_image,_addr) (((_image)->starts[(_addr) >> 3] >> ((_addr) & 7)) & 1)
+
+void gat_image_begin (gat *ga);
+void gat_image_free (gat *ga);
+int gat_image_write (gat_image *image, uint32_t offset, const uint8_t *bytes, unsigned size, 
+                     uint32_t line_num);
+int gat_image_next_run (const gat_image *image, uint32_t *start, uint32_t *length);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__gat_image_h__ */
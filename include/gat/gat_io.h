@@ -26,6 +26,12 @@
 extern "C" {
 #endif
 
+void gat_load_source (gat *ga);
+void gat_unload_source (gat *ga);
+int gat_preload_source (gat *ga);
+void gat_set_source (gat *ga, const char *path, const char *text, size_t size);
+void gat_rewind_source (gat *ga);
+#define gat_end_of_source(_ga) ((_ga)->src_pos >= (_ga)->src_size)
 void gat_open_files (gat *ga);
 void gat_close_files (gat *ga);
 int gat_read_line (gat *ga);
@@ -26,25 +26,31 @@
 extern "C" {
 #endif
 
-int gat_test_byte (gat *ga, const char *token);
-int gat_test_dbl (gat *ga, const char *token);
-int gat_test_token (gat *ga, const char *token, int optype);
+int gat_is_reg (gat *ga, const char *token);
+int gat_test_byte (gat *ga, unsigned index);
+int gat_test_dbl (gat *ga, unsigned index);
+int gat_test_token (gat *ga, unsigned index, int optype);
 
-int gat_parse_byte (gat *ga, const char *token, uint8_t *value);
-int gat_parse_dbl (gat *ga, const char *token, uint16_t *value);
-int gat_parse_token (gat *ga, const char *token, int optype, void *value);
+int gat_parse_byte (gat *ga, unsigned index, uint8_t *value);
+int gat_parse_dbl (gat *ga, unsigned index, uint16_t *value);
+int gat_parse_token (gat *ga, unsigned index, int optype, void *value);
 
 int gat_parse_org (gat *ga);
 int gat_parse_equ (gat *ga);
 int gat_parse_label (gat *ga);
 
+unsigned gat_find_directives (gat *ga, int *found);
 void gat_scan_directives (gat *ga, int *dirt, int *end);
-void gat_parse_directives (gat *ga, int *dirt, int *end);
 
 int gat_scan_instruction (gat *ga, const gat_instr *instr);
+int gat_gen_instruction (gat *ga, const gat_instr *instr);
 int gat_assemble_instruction (gat *ga, const gat_instr *instr);
+void gat_scan_line (gat *ga, int *flag_end);
 int gat_scan (gat *ga);
 int gat_assemble (gat *ga);
+void gat_patch_fixups (gat *ga);
+int gat_emit_image (gat *ga);
+void gat_emit_state (gat *ga, gat_emitter_state state);
 void gat_emit (gat *ga);
 
 #ifdef __cplusplus
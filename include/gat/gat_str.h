@@ -39,10 +39,11 @@ extern "C" {
 #endif
 #define gat_strcmp(_s1,_s2) (!strcmp(_s1,_s2))
 #define gat_strcmpi(_s1,_s2) (!strcmpi(_s1,_s2))
-int gat_rngcmp (char, const char *);
-char *gat_unquote (const char *, char *buff);
-char *gat_trim (const char *, char *);
-char *gat_format_string (const char *format, va_list arg_list);
+int gat_strcmpi_view (const char *, const char *, size_t);
+size_t gat_trim_view (const char **, size_t);
+uint32_t gat_hash_keyword (uint32_t seed, const char *, size_t);
+uint64_t gat_hash_bytes (uint64_t seed, const void *, size_t);
+size_t gat_format_buff (char *buff, size_t size, const char *format, va_list arg_list);
 
 /* gat commandline parser functions */
 uint32_t gat_cmdln_scan_switches (gat_cmdline *pcmd, const char *arr_switches[], 
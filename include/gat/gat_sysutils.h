@@ -29,6 +29,9 @@ extern "C" {
 /* Attaches extension name to path discarding the current extension name. */
 char *gat_attach_extension (gat *ga, char *path, const char *ext);
 
+/* Reads monotonic wall clock and CPU clock of the calling thread in nanoseconds. */
+void gat_clock (uint64_t *wall_ns, uint64_t *cpu_ns);
+
 #ifdef __cplusplus
 } /* extern "C" { */
 #endif
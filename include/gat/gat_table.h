@@ -26,11 +26,17 @@
 extern "C" {
 #endif
 
-int gat_search_instr (gat *ga, const char *);
+int gat_search_keyword (gat *ga, const char *, size_t);
+int gat_search_instr (gat *ga, const char *, size_t);
 int gat_search_id (gat *ga, const char *);
 int gat_define_id (gat *ga, const char *, uint16_t, uint8_t);
 int gat_search_label (gat *ga, const char *);
 int gat_define_label (gat *ga, const char *, uint16_t);
+int gat_search_macro (gat *ga, const char *);
+int gat_define_macro (gat *ga, const char *, unsigned);
+void gat_symtab_init (gat *ga);
+void gat_symtab_reset (gat *ga);
+void gat_symtab_free (gat *ga);
 
 #ifdef __cplusplus
 } /* extern "C" { */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __gat_thread_h__
+#define __gat_thread_h__
+
+#include "gat_types.h"
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* worker thread; runs run(arg) */
+typedef struct _gat_thread {
+#ifdef WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    void (* run) (void *);
+    void *arg;
+}gat_thread;
+
+/* counter shared between threads without locks. loads acquire and stores 
+   release, so data written before a store is visible after the load. */
+typedef volatile long gat_atomic;
+
+#ifdef WIN32
+#define gat_atomic_load(_p)         InterlockedCompareExchange ((_p), 0, 0)
+#define gat_atomic_store(_p,_v)     InterlockedExchange ((_p), (_v))
+#else
+#define gat_atomic_load(_p)         __atomic_load_n ((_p), __ATOMIC_ACQUIRE)
+#define gat_atomic_store(_p,_v)     __atomic_store_n ((_p), (_v), __ATOMIC_RELEASE)
+#endif
+
+/* lock guarding state shared between threads; statically initialized with 
+   GAT_MUTEX_INIT */
+#ifdef WIN32
+typedef SRWLOCK gat_mutex;
+#define GAT_MUTEX_INIT              SRWLOCK_INIT
+#else
+typedef pthread_mutex_t gat_mutex;
+#define GAT_MUTEX_INIT              PTHREAD_MUTEX_INITIALIZER
+#endif
+
+int gat_thread_start (gat_thread *thread, void (* run) (void *), void *arg);
+void gat_thread_join (gat_thread *thread);
+void gat_thread_yield (void);
+void gat_mutex_lock (gat_mutex *mutex);
+void gat_mutex_unlock (gat_mutex *mutex);
+unsigned gat_num_processors (void);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__gat_thread_h__ */
@@ -20,20 +20,42 @@
 #define __TOKENIZER_H__
 
 #include "gat_types.h"
+#include "gat_ctype.h"
 
 #include <string.h>
 #ifdef WIN32
 #pragma warning (disable:4996) /* deprecated */
 #endif
 
-#define gat_is_white(_c) (strchr(GAT_WHITE,_c)?1:0)
-#define gat_is_delim(_c) (strchr(GAT_SYMBOLS,(_c))?1:0)
-#define gat_is_symbol(_c) (strchr(GAT_SYMBOLS,(_c))?1:0)
+#define gat_is_white(_c) gat_ctype_is((_c),GAT_CC_WHITE)
+#define gat_is_delim(_c) gat_ctype_is((_c),GAT_CC_SYMBOL)
+#define gat_is_symbol(_c) gat_ctype_is((_c),GAT_CC_SYMBOL)
 
 int gat_is_whitespace_token (const gat_token *token);
+int gat_token_equi (const gat_token *token, const char *str);
+const char *gat_token_cstr (gat *ga, unsigned index);
+
+/* cached number value and width of token at index */
+#define gat_token_value(_ga,_i) ((_ga)->arr_raw_tokens[_i].num_value)
+#define gat_token_width(_ga,_i) ((_ga)->arr_raw_tokens[_i].num_width)
+#define gat_token_is_byte(_ga,_i) (gat_token_width(_ga,_i) == GAT_NUMW_BYTE)
+#define gat_token_is_dbl(_ga,_i) \
+(gat_token_width(_ga,_i) == GAT_NUMW_BYTE || gat_token_width(_ga,_i) == GAT_NUMW_DBL)
+
+/* null terminated text of token at index; made on first use */
+#define gat_token_str(_ga,_i) \
+((_ga)->arr_tokens[_i] ? (_ga)->arr_tokens[_i] : gat_token_cstr((_ga),(_i)))
+
+/* gat_tokenize_text status flags */
+#define GAT_TOKENIZE_TOO_MANY       1   /* line has more than GAT_MAX_TOKENS tokens; dropped */
+#define GAT_TOKENIZE_OPEN_QUOTE     2   /* unterminated string */
 
 unsigned gat_tokenize_line (gat *ga);
+void gat_prepare_tokens (gat *ga);
+void gat_tokenize_errors (gat *ga, unsigned status);
 size_t gat_tokenize (gat *ga);
+unsigned gat_tokenize_text (const char *line, size_t line_len, gat_token *tokens, 
+                            unsigned *num_tokens);
 void gat_free_tokens (gat *ga);
 
 #if _DEBUG
@@ -20,13 +20,16 @@
 #define __gat_types_h__
 
 #include <stdio.h>
+#include <setjmp.h>
 
 /* define fixed size types for cross platform compatibility */
 #ifdef WIN32
 /* basic int types */
+typedef signed char int8_t;
 typedef unsigned char uint8_t;
 typedef unsigned short uint16_t;
 typedef unsigned long uint32_t;
+typedef unsigned __int64 uint64_t;
 #else
 #  include <stdint.h>
 #endif
@@ -40,6 +43,13 @@ typedef char * gat_char;
 #define GAT_ORG                     1
 #define GAT_END                     2
 #define GAT_LABEL                   3
+#define GAT_MACRO                   4
+#define GAT_ENDM                    5
+#define GAT_INCLUDE                 6
+#define GAT_IF                      7
+#define GAT_IFDEF                   8
+#define GAT_ELSE                    9
+#define GAT_ENDIF                   10
 
 /* define constants */
 #define GAT_WHITE                   "\r\n\f\t\v "
@@ -47,17 +57,21 @@ typedef char * gat_char;
 #define GAT_COMMENT_CHAR            ';'
 
 #define GAT_MAX_IO                  5
-#define GAT_MAX_IDS                 1000
-#define GAT_MAX_LABELS              GAT_MAX_IDS
-#define GAT_MAX_TOKENS              4
+#define GAT_MAX_TOKENS              64  /* tokens of a line; operands may be long expressions */
 #define GAT_MAX_TOKEN_LEN           16
 #define GAT_MAX_MNEMONIC_LEN        4
 #define GAT_MAX_ID_LEN              16
 #define GAT_MAX_PATH                255
 #define GAT_MAX_LINEBUFF_SIZE       255
-#define GAT_MAX_ERRORS              100
+#define GAT_MAX_ERRORS              100 /* default error limit of a source */
+#define GAT_MAX_MACRO_DEPTH         16  /* nesting of macro expansions */
+#define GAT_MAX_INCLUDE_DEPTH       16  /* nesting of included files */
+#define GAT_MAX_COND_DEPTH          32  /* nesting of evaluated IF blocks */
+#define GAT_MAX_MSG_SIZE            1024 /* formatted message size; longer ones are cut */
 #define GAT_MAX_BYTE                0xFF
 #define GAT_MAX_DBL                 0xFFFF
+#define GAT_MIN_BYTE                (-0x80)     /* least byte; negatives are two's complement */
+#define GAT_MIN_DBL                 (-0x8000)
 
 #define \
 GAT_MAX_NUMERIC_TOKEN_LENGTH        6
@@ -74,7 +88,82 @@ GAT_MAX_NUMERIC_TOKEN_LENGTH        6
 /* constants for Intel HEX file format */
 #define INTEL_HEX_RECTYPE_DATA      0
 #define INTEL_HEX_RECTYPE_EOF       1
-#define INTEL_MAX_HEX_RECSIZE       16
+#define INTEL_MAX_HEX_RECSIZE       16      /* default record length */
+#define INTEL_HEX_RECSIZE_LIMIT     255     /* largest record length */
+#define INTEL_HEX_RECTEXT_SIZE      (1 + 2 + 4 + 2 + INTEL_HEX_RECSIZE_LIMIT * 2 + 2 + 2)
+
+/* width of a numeric token value */
+#define GAT_NUMW_NONE               0   /* not a number */
+#define GAT_NUMW_BYTE               1   /* 0 - 0xFF */
+#define GAT_NUMW_DBL                2   /* 0x100 - 0xFFFF */
+#define GAT_NUMW_WIDE               3   /* above 0xFFFF */
+
+/* line IR kinds */
+#define GAT_LINE_INSTR              0
+#define GAT_LINE_ORG                1
+#define GAT_LINE_DIRT               2   /* directive; scanned in order after parallel pass #1 */
+#define GAT_LINE_NONE               3   /* line raising diagnostics only; parallel pass #1 */
+
+/* size of the code memory image; the 8085 address space */
+#define GAT_IMAGE_SIZE              0x10000
+
+/* engines */
+#define GAT_ENGINE_TWO_PASS         0   /* analysis pass, then assembly pass over the IR */
+#define GAT_ENGINE_SINGLE_PASS      1   /* code generated on analysis; forward references fixed up */
+
+/* pass #1 pipeline; sources smaller than GAT_PIPE_MIN_SOURCE bytes are 
+   scanned serially as threads would cost more than they save */
+#define GAT_PIPE_MAX_THREADS        16
+#define GAT_PIPE_MIN_SOURCE         (256 * 1024)
+
+/* parallel engine stages; sources with fewer IR lines than GAT_PAR_MIN_LINES 
+   are assembled serially */
+#define GAT_PAR_MAX_THREADS         64
+#define GAT_PAR_MIN_LINES           16384
+
+/* sources smaller than GAT_PAR_MIN_SOURCE bytes are scanned serially */
+#define GAT_PAR_MIN_SOURCE          (256 * 1024)
+
+/* engine phases timed by stats */
+#define GAT_PHASE_OPEN              0   /* opening files and loading source */
+#define GAT_PHASE_PASS1             1   /* analysis; gat_scan */
+#define GAT_PHASE_PASS2             2   /* assembly; gat_assemble or fixups */
+#define GAT_PHASE_EMIT              3   /* emitters */
+#define GAT_PHASE_CLEANUP           4   /* closing files */
+#define GAT_NUM_PHASES              5
+
+/* expression code ops; postfix */
+#define GAT_EXPR_END                0
+#define GAT_EXPR_CONST              1
+#define GAT_EXPR_SYMBOL             2   /* label or id resolved when evaluated */
+#define GAT_EXPR_NEG                3   /* unary */
+#define GAT_EXPR_NOT                4
+#define GAT_EXPR_HIGH               5
+#define GAT_EXPR_LOW                6
+#define GAT_EXPR_MUL                7   /* binary */
+#define GAT_EXPR_DIV                8
+#define GAT_EXPR_MOD                9
+#define GAT_EXPR_ADD                10
+#define GAT_EXPR_SUB                11
+#define GAT_EXPR_SHL                12
+#define GAT_EXPR_SHR                13
+#define GAT_EXPR_AND                14
+#define GAT_EXPR_XOR                15
+#define GAT_EXPR_OR                 16
+
+/* line IR operand classes */
+#define GAT_OPCLASS_NONE            0   /* parse from token text in pass #2 */
+#define GAT_OPCLASS_CONST           1   /* value cooked in pass #1 */
+
+/* symbol kinds */
+#define GAT_SYM_NONE                0
+#define GAT_SYM_ID                  1
+#define GAT_SYM_LABEL               2
+#define GAT_SYM_MACRO               3
+
+/* keyword codes in the keyword table; instruction index or directive flag */
+#define GAT_KW_NONE                 -1
+#define GAT_KW_DIRT                 0x4000
 
 /* define bit mask for command line switches */
 #define GAT_NUM_SWITCHES            5
@@ -89,7 +178,8 @@ typedef enum _gat_token_type {
     GAT_TOK_WORD,
     GAT_TOK_SYMBOL,
     GAT_TOK_WHITE,
-    GAT_TOK_STRING
+    GAT_TOK_STRING,
+    GAT_TOK_EXPR                /* operand expression; num_value is its first code op */
 }gat_token_type; /* enum gat_token_type */
 
 typedef enum _gat_callback_type {
@@ -104,9 +194,7 @@ typedef void (*gat_callback) \
 struct _gat_io;
 typedef enum _gat_emitter_state {
     GAT_EMIT_BEGIN_ASSEMBLY,
-    GAT_EMIT_END_ASSEMBLY,
-    GAT_EMIT_SET_ORG,
-    GAT_EMIT_CODE
+    GAT_EMIT_END_ASSEMBLY       /* code is in the memory image; serialize it */
 }gat_emitter_state;
 
 /* gat_emitter type */
@@ -142,18 +230,36 @@ typedef struct _gat_cmdline {
 
 /* LABEL */
 typedef struct _gat_label {
-    char name [GAT_MAX_ID_LEN + 1];
+    uint32_t name;              /* offset of interned name in symtab names */
     uint16_t address;
 }gat_label;
 
 /* ID */
 typedef struct _gat_id {
-    char name [GAT_MAX_ID_LEN + 1];
+    uint32_t name;              /* offset of interned name in symtab names */
     uint16_t data;
     uint8_t idtype;
     /* uint8_t assumed; */
 }gat_id;
 
+/* symbol table slot; ids and labels share one namespace */
+typedef struct _gat_symbol {
+    uint32_t hash;              /* hash of name */
+    uint32_t name;              /* offset of interned name in symtab names */
+    uint32_t index;             /* index in arr_ids, arr_labels or arr_macros */
+    uint8_t kind;               /* GAT_SYM_*; GAT_SYM_NONE for an empty slot */
+}gat_symbol;
+
+/* open addressing hash table of ids, labels and macros */
+typedef struct _gat_symtab {
+    gat_symbol *slots;
+    unsigned num_slots;         /* power of 2 */
+    unsigned num_symbols;
+    char *names;                /* interned null terminated names */
+    size_t names_size;
+    size_t max_names_size;
+}gat_symtab;
+
 /* directive */
 typedef struct _gat_dir {
     uint8_t token;
@@ -162,6 +268,16 @@ typedef struct _gat_dir {
     uint8_t num_tokens;
 }gat_dirt;
 
+/* perfect hash keyword table over mnemonics and directive commands. 
+   generated at build time from the instruction and directive tables. */
+typedef struct _gat_kwtable {
+    uint32_t seed;              /* seed of gat_hash_keyword */
+    unsigned num_buckets;       /* power of 2 */
+    unsigned num_slots;         /* power of 2 */
+    const uint16_t *disp;       /* slot displacement per bucket */
+    const int16_t *slots;       /* GAT_KW_* code per slot */
+}gat_kwtable;
+
 /* INSTR */
 typedef struct _gat_instr {
     char mnemonic [GAT_MAX_MNEMONIC_LEN + 1]; /* mnemonic */
@@ -179,13 +295,197 @@ typedef struct _INTEL_HEX_RECORD {
     uint8_t type;
 }INTEL_HEX_RECORD;
 
-/* struct gat_token */
+/* struct gat_token; a slice of the source line, not null terminated */
 typedef struct _gat_token {
-    char *string;               /* pointer to actual string */
+    const char *string;         /* pointer to the token text in source */
     size_t length;              /* length of string */
     gat_token_type type;        /* type of token */
+    uint32_t num_value;         /* value if token is a number */
+    uint8_t num_width;          /* GAT_NUMW_*; decoded once when tokenized */
 }gat_token;
 
+/* macro body token; param is the index of the parameter it stands for, -1 if none */
+typedef struct _gat_macro_token {
+    gat_token token;            /* token slice in source */
+    int8_t param;
+}gat_macro_token;
+
+/* macro body line; tokenized once when the macro is defined */
+typedef struct _gat_macro_line {
+    uint32_t token_base;        /* index of the first token in macro tokens */
+    uint8_t num_tokens;
+}gat_macro_line;
+
+/* MACRO */
+typedef struct _gat_macro {
+    uint8_t num_params;
+    uint32_t first_line;        /* index of the first body line in macro lines */
+    uint32_t num_lines;
+    uint32_t param_base;        /* index of the parameter tokens in macro tokens */
+    uint32_t line_num;          /* source line of the definition */
+    uint16_t file;              /* file of the definition; see gat.file */
+}gat_macro;
+
+/* expression code op */
+typedef struct _gat_expr_op {
+    uint8_t op;                 /* GAT_EXPR_* */
+    int32_t value;              /* value of GAT_EXPR_CONST */
+    uint32_t name;              /* GAT_EXPR_SYMBOL; offset of the name in expr names */
+}gat_expr_op;
+
+/* block of expression texts rebuilt from the tokens of macro lines; blocks 
+   stay in place as tokens point into them */
+#define GAT_EXPR_TEXT_BLOCK_SIZE    4096
+typedef struct _gat_expr_texts {
+    struct _gat_expr_texts *next;
+    size_t size;
+    char text [GAT_EXPR_TEXT_BLOCK_SIZE];
+}gat_expr_texts;
+
+/* open IF block */
+typedef struct _gat_cond {
+    uint32_t line_num;          /* line of the IF */
+    uint16_t file;              /* file of the IF; see gat.file */
+    uint8_t taken;              /* has a branch been assembled? */
+    uint8_t has_else;           /* ELSE seen? */
+}gat_cond;
+
+/* line of an included file; tokenized once when the file is cached */
+typedef struct _gat_incl_line {
+    uint32_t line_num;          /* line no in the file */
+    uint32_t token_base;        /* index of the first token in file tokens */
+    uint8_t num_tokens;
+    uint8_t status;             /* GAT_TOKENIZE_* errors to report */
+}gat_incl_line;
+
+/* included file in the process wide cache, keyed by path and modification 
+   time. contexts holding a reference share it read only. */
+typedef struct _gat_incl_file {
+    struct _gat_incl_file *next;
+    char path [GAT_MAX_PATH + 1];
+    uint64_t mtime;             /* modification time with sub-second resolution */
+    uint64_t size;
+    unsigned refs;              /* contexts using the file */
+    int stale;                  /* file changed; freed with its last reference */
+    char *text;                 /* tokens are slices of it */
+    gat_incl_line *lines;       /* lines with tokens or tokenizer errors */
+    unsigned num_lines;
+    uint32_t total_lines;       /* lines in file, blank lines included */
+    gat_token *tokens;
+    unsigned num_tokens;
+}gat_incl_file;
+
+/* line IR; a scanned source line retained from pass #1 for pass #2 */
+typedef struct _gat_line {
+    uint32_t line_num;          /* source line no */
+    uint32_t offset;            /* code offset in pass #1 */
+    int instr;                  /* instruction index; -1 for directives */
+    uint8_t kind;               /* GAT_LINE_* */
+    uint8_t num_tokens;         /* number of tokens */
+    uint16_t file;              /* file of the line; see gat.file */
+    uint32_t token_base;        /* index of the first token in ir.tokens */
+    uint8_t bin[3];             /* code generated by single pass engine or parallel pass #2 */
+    uint8_t bin_size;           /* size of code; 0 if none generated */
+}gat_line;
+
+/* line IR token */
+typedef struct _gat_ir_token {
+    gat_token token;            /* token slice in source */
+    uint16_t value;             /* cooked value for GAT_OPCLASS_CONST */
+    uint8_t opclass;            /* GAT_OPCLASS_* */
+}gat_ir_token;
+
+/* line IR of a source */
+typedef struct _gat_ir {
+    gat_line *lines;
+    unsigned num_lines;
+    unsigned max_lines;
+    gat_ir_token *tokens;
+    unsigned num_tokens;
+    unsigned max_tokens;
+    unsigned *fixups;           /* lines referencing symbols not yet defined */
+    unsigned num_fixups;
+    unsigned max_fixups;
+}gat_ir;
+
+/* memory image the assembly phase writes code into; emitters serialize it at the 
+   end of assembly. a coverage bit is set for each address written and a start 
+   bit for the first address of each instruction. */
+typedef struct _gat_image {
+    uint8_t bytes [GAT_IMAGE_SIZE];
+    uint8_t coverage [GAT_IMAGE_SIZE / 8];
+    uint8_t starts [GAT_IMAGE_SIZE / 8];
+    uint32_t lines [GAT_IMAGE_SIZE];        /* source line of each instruction start */
+    uint32_t covered;                       /* number of addresses written */
+    int overlapping;                        /* did the last write overlap earlier code? */
+}gat_image;
+
+/* diagnostic raised on a worker thread; reported in line order afterwards */
+typedef struct _gat_par_diag {
+    uint32_t index;             /* IR line */
+    uint32_t line_num;          /* source line no */
+    int err_no;
+    uint8_t warning;
+    size_t text;                /* offset of description in worker text */
+}gat_par_diag;
+
+/* chunk line parallel pass #1 leaves to the ordered merge; a directive or a 
+   line with diagnostics */
+typedef struct _gat_par_event {
+    uint32_t index;             /* chunk IR line */
+    uint32_t bytes;             /* code size of the chunk lines since the previous event */
+    uint64_t tokens;            /* tokens and lookups of the chunk up to the line */
+    uint64_t kw_lookups;
+}gat_par_event;
+
+/* worker of a parallel engine stage */
+typedef struct _gat_par_worker {
+    struct _gat *ctx;           /* private assembler state; shares the tables of the source */
+    unsigned first;             /* IR lines [first, last) handled by the worker */
+    unsigned last;
+    unsigned current;           /* IR line being handled */
+    gat_par_diag *diags;
+    unsigned num_diags;
+    unsigned max_diags;
+    char *text;                 /* descriptions of diags */
+    size_t text_size;
+    size_t max_text_size;
+    int failed;                 /* ran out of memory or met a macro, include or IF; the stage is redone serially */
+    /* parallel pass #1 */
+    const char *begin;          /* chunk of source text */
+    const char *end;
+    gat_ir ir;                  /* chunk lines; bin_size holds the code size */
+    gat_par_event *events;
+    unsigned num_events;
+    unsigned max_events;
+    uint32_t num_lines;         /* lines in chunk, blank lines included */
+    uint32_t tail_bytes;        /* code size of the lines after the last event */
+    uint64_t num_tokens;        /* tokens in chunk */
+    unsigned ir_lines;          /* lines and tokens the chunk adds to the IR */
+    unsigned ir_tokens;
+}gat_par_worker;
+
+/* engine statistics of a source; counters are always kept, phases are 
+   timed when stats are enabled */
+typedef struct _gat_stats {
+    uint64_t wall_ns [GAT_NUM_PHASES];  /* wall time per phase */
+    uint64_t cpu_ns [GAT_NUM_PHASES];   /* thread CPU time per phase */
+    uint64_t source_bytes;
+    uint64_t lines;                     /* lines read */
+    uint64_t tokens;                    /* tokens produced */
+    uint64_t sym_lookups;               /* symbol table probes */
+    uint64_t sym_probes;                /* slots inspected by symbol probes */
+    uint64_t kw_lookups;                /* mnemonic and directive lookups */
+    uint64_t macro_expansions;          /* macro invocations expanded */
+    uint64_t macro_lines;               /* body lines scanned by expansions */
+    uint64_t includes;                  /* files included */
+    uint64_t include_hits;              /* included files found tokenized in the cache */
+    uint64_t skipped_lines;             /* lines of false conditional blocks */
+    uint64_t emit_calls;                /* emitter calls */
+    uint64_t emit_bytes;                /* code bytes emitted */
+    uint64_t peak_heap;                 /* peak heap held by the context */
+}gat_stats;
+
 /* gat arch interface */
 typedef struct _gat_arch {
     int (* is_reg8) (const char *);
@@ -206,36 +506,91 @@ typedef struct _gat_arch {
 typedef struct _gat {
     gat_callback callback;
     void *context;
-    gat_arch *arch;
-    int fatal_error;
+    const gat_arch *arch;
+    int fatal_error;            /* error number of the fatal error; 0 if none */
+    jmp_buf fatal_jmp;          /* fatal errors unwind here while the engine runs */
+    int fatal_jmp_armed;
     unsigned num_ids;
-    gat_id arr_ids[GAT_MAX_IDS];
-    unsigned num_labels ;
-    gat_label arr_labels[GAT_MAX_LABELS];
+    unsigned max_ids;
+    gat_id *arr_ids;
+    unsigned num_labels;
+    unsigned max_labels;
+    gat_label *arr_labels;
+    unsigned num_macros;
+    unsigned max_macros;
+    gat_macro *arr_macros;
+    gat_macro_line *macro_lines;
+    unsigned num_macro_lines;
+    unsigned max_macro_lines;
+    gat_macro_token *macro_tokens;
+    unsigned num_macro_tokens;
+    unsigned max_macro_tokens;
+    int macro_def;              /* macro whose body is being recorded; -1 if none */
+    unsigned macro_depth;       /* expansions in progress */
+    gat_incl_file **includes;   /* files referenced by the source */
+    unsigned num_includes;
+    unsigned max_includes;
+    uint16_t file;              /* file of the current line; 0 for the source, 
+                                   n for includes[n - 1] */
+    uint16_t include_stack [GAT_MAX_INCLUDE_DEPTH + 1];  /* files being scanned; the source first */
+    unsigned include_depth;
+    const char *include_dir;    /* directory of the includes of a source set from 
+                                   memory; NULL rejects them */
+    gat_expr_op *expr_ops;      /* code of operand expressions referencing symbols */
+    unsigned num_expr_ops;
+    unsigned max_expr_ops;
+    char *expr_names;           /* null terminated names of expression symbols */
+    size_t expr_names_size;
+    size_t max_expr_names_size;
+    gat_expr_texts *expr_texts; /* newest block first */
+    gat_cond cond_stack [GAT_MAX_COND_DEPTH];   /* IF blocks being assembled or skipped */
+    unsigned num_conds;
+    unsigned cond_skip;         /* 0 if assembling; else 1 + IFs opened in the skipped block */
+    gat_symtab symtab;
     gat_io ios [GAT_MAX_IO];
     unsigned num_ios;
     unsigned pass;
     unsigned err_count;
     unsigned warn_count;
+    unsigned max_errors;        /* assembly stops at this many errors; 0 for no limit */
+    char msg_buff [GAT_MAX_MSG_SIZE];   /* messages are formatted here for the callback */
     uint32_t line_num;
     uint32_t org;
     uint32_t offset;
     uint32_t size;
-    char str_line [GAT_MAX_LINEBUFF_SIZE + 1];
+    const char *src;            /* source text; mapped, read in full or borrowed */
+    size_t src_size;            /* size of source text */
+    size_t src_pos;             /* read position in source text */
+    int src_mapped;             /* is source text memory mapped? */
+    int src_borrowed;           /* is source text the caller's buffer? */
+    const char *line;           /* current line view; not null terminated */
+    size_t line_len;            /* length of current line view */
     unsigned num_tokens;
-    char *arr_tokens [GAT_MAX_TOKENS];
+    const char *arr_tokens [GAT_MAX_TOKENS];    /* terminated token text; made on demand */
     gat_token arr_raw_tokens [GAT_MAX_TOKENS];
+    char arr_token_text [GAT_MAX_TOKENS][GAT_MAX_LINEBUFF_SIZE + 1];
     uint16_t arr_cooked_tokens [GAT_MAX_TOKENS];
+    uint8_t arr_token_class [GAT_MAX_TOKENS];
+    gat_ir ir;
+    gat_image *image;           /* allocated on first assembly; reused after */
     uint8_t bin[3];
     unsigned bin_size;
     unsigned long cmdline_flags;
-    uint16_t rec_length;
-    uint32_t offset_hexrec;
-    uint8_t checksum;
-    gat_dirt *dirt_table;
+    int engine;                 /* GAT_ENGINE_* */
+    int stats_enabled;          /* time engine phases? */
+    unsigned num_pipe_threads;  /* reader / tokenizer threads of pass #1; 0 scans serially */
+    unsigned num_threads;       /* threads of parallel engine stages; 1 runs them serially */
+    gat_par_worker *workers;    /* allocated on first parallel stage; reused after */
+    unsigned num_workers;
+    gat_stats stats;
+    uint16_t max_rec_length;    /* HEX data record length */
+    char hex_record[INTEL_HEX_RECTEXT_SIZE];    /* HEX record text being built */
+    const gat_dirt *dirt_table;
     unsigned len_dirt_table;
-    gat_instr *instr_table;
+    const gat_instr *instr_table;
     unsigned len_instr_table;
+    const gat_kwtable *kw_table;
+    unsigned max_dirt_token_index;
 }gat;
 
 #endif /* !__gat_types_h__ */
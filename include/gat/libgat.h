@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** libgat.h  in-memory 8085 assembler API of libgat. 
+    
+    This is the stable interface of the libgat library. It assembles a source 
+    held in memory and returns the code image, the symbol table and the 
+    diagnostics in memory. No file is written, and none is read unless an 
+    include directory is set with libgat_set_include_dir; INCLUDE is an error 
+    otherwise. The header depends on no other gat header and types here only 
+    grow by appending members. */
+#ifndef __libgat_h__
+#define __libgat_h__
+
+#include <stddef.h>
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* version of this interface; bumped whenever it changes */
+#define LIBGAT_API_VERSION          3
+
+/* size of the code image; the 8085 address space */
+#define LIBGAT_IMAGE_SIZE           0x10000
+
+/* libgat_assemble flags */
+#define LIBGAT_SINGLE_PASS          0x01    /* generate code on analysis; fix up forward references */
+
+/* diagnostic kinds */
+#define LIBGAT_DIAG_ERROR           0
+#define LIBGAT_DIAG_WARNING         1
+#define LIBGAT_DIAG_FATAL           2       /* assembly stopped at this error */
+
+/* symbol kinds */
+#define LIBGAT_SYM_BYTE             1       /* byte equ */
+#define LIBGAT_SYM_WORD             2       /* word equ */
+#define LIBGAT_SYM_LABEL            3
+
+/* assembler handle; owns the results of its last assembly */
+typedef struct _libgat libgat;
+
+/* diagnostic */
+typedef struct _libgat_diag {
+    int kind;                   /* LIBGAT_DIAG_* */
+    int code;                   /* gat error number */
+    unsigned line;              /* source line; 0 if not on a line */
+    const char *text;           /* description */
+    const char *file;           /* name of the source or path of the included file 
+                                   the line is in */
+}libgat_diag;
+
+/* symbol */
+typedef struct _libgat_symbol {
+    const char *name;
+    int kind;                   /* LIBGAT_SYM_* */
+    unsigned value;             /* value or address */
+}libgat_symbol;
+
+/* results of an assembly; valid until the next assembly with the handle or 
+   until the handle is destroyed */
+typedef struct _libgat_result {
+    int status;                 /* 0 on success, -1 on errors, else the fatal error number */
+    unsigned err_count;
+    unsigned warn_count;
+    unsigned long size;         /* code bytes assembled */
+    const unsigned char *image;     /* LIBGAT_IMAGE_SIZE bytes; NULL unless status is 0 */
+    const unsigned char *coverage;  /* bit (addr & 7) of byte (addr >> 3) is set for 
+                                       each address holding code; NULL with image */
+    const libgat_diag *diags;   /* diagnostics in the order reported */
+    unsigned num_diags;
+    const libgat_symbol *symbols;   /* equs then labels in the order defined */
+    unsigned num_symbols;
+}libgat_result;
+
+/* returns LIBGAT_API_VERSION the library was built with */
+int libgat_version (void);
+
+/* creates an assembler; NULL if out of memory. a handle may be used by one 
+   thread at a time; separate handles can assemble in parallel. */
+libgat *libgat_create (void);
+
+/* sets the error limit of the handle; assembly stops with a fatal error once 
+   a source reaches it. 100 by default, 0 for no limit. */
+void libgat_set_max_errors (libgat *lg, unsigned max_errors);
+
+/* sets the directory INCLUDE reads relative paths from; the handle keeps a 
+   copy. NULL or "", the default, rejects INCLUDE so that no file is read. */
+void libgat_set_include_dir (libgat *lg, const char *dir);
+
+/* assembles size bytes of source text; name identifies the source in 
+   diagnostics. source is neither modified nor kept past the call. returns 
+   result->status. */
+int libgat_assemble (libgat *lg, const char *name, const char *source, size_t size, 
+                     int flags, libgat_result *result);
+
+/* finds the run of code at or after *start in the image of the last successful 
+   assembly. returns 0 once there are no more runs. */
+int libgat_next_run (const libgat *lg, unsigned *start, unsigned *length);
+
+/* destroys the assembler and the results it owns */
+void libgat_destroy (libgat *lg);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__libgat_h__ */
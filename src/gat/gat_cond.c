@@ -0,0 +1,181 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_cond.c  IF / IFDEF / ELSE / ENDIF. lines of a false block are neither 
+    tokenized nor looked up; the first word of each is only matched against 
+    the conditional directives to follow the blocks nested in it. */
+#include "gat_cond.h"
+#include "gat_expr.h"
+#include "gat_core.h"
+#include "gat_str.h"
+#include "gat_ctype.h"
+#include "gat_lexer.h"
+#include "gat_parser.h"
+#include "gat_table.h"
+#include "gat_tokenizer.h"
+#include "gat_err.h"
+
+/* words longer than this are not matched against the conditional directives */
+#define GAT_COND_MAX_WORD           8
+
+/* closes all IF blocks */
+void gat_cond_reset (gat *ga) {
+    ga->num_conds = 0;
+    ga->cond_skip = 0;
+}
+
+/* evaluates operand of IF -> byte | dbl | id | expr as EQU does; an operand that 
+   isn't a constant is reported and taken as true */
+static int gat_cond_value (gat *ga) {
+    if ( gat_token_is_dbl(ga, 1) ) {
+        return gat_token_value(ga, 1) != 0;
+    } else if ( gat_is_id (gat_token_str(ga, 1)) ) {
+        int index = gat_search_id (ga, gat_token_str(ga, 1));
+        if (index != -1) {
+            return ga->arr_ids[index].data != 0;
+        }
+        gat_error (ga, GAT_ERR_UNDEFINED_ID, "undefined identifier : %s", gat_token_str(ga, 1));
+        return 1;
+    }
+    gat_error (ga, GAT_ERR_CONST_EXPECTED, "constant expected : if");
+    return 1;
+}
+
+/* tests if operand of IFDEF names an id, label or macro defined so far */
+static int gat_cond_defined (gat *ga) {
+    const char *name = gat_token_str(ga, 1);
+
+    if ( !gat_is_id (name) ) {
+        gat_error (ga, GAT_ERR_INVALID_ID, "invalid identifier : %s", name);
+        return 1;
+    }
+    return gat_search_id (ga, name) != -1 || gat_search_label (ga, name) != -1 || 
+           (ga->num_macros > 0 && gat_search_macro (ga, name) != -1);
+}
+
+/* parses a conditional directive of a line being assembled, or the ELSE or 
+   ENDIF ending a false block. the blocks stay paired when operands are 
+   invalid. */
+void gat_parse_cond (gat *ga, int token) {
+    unsigned num_tokens = (token == GAT_IF || token == GAT_IFDEF) ? 2 : 1;
+    gat_cond *cond;
+    int valid = 1;
+
+    /* an invalid expression is reported and taken as true */
+    if (token == GAT_IF && ga->num_tokens > num_tokens) {
+        valid = gat_expr_value (ga, 1);
+    }
+
+    if (valid && ga->num_tokens != num_tokens) {
+        gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid number of operands : %s", 
+                    gat_token_str(ga, 0));
+    }
+
+    switch (token) {
+    case GAT_IF:
+    case GAT_IFDEF:
+        if (ga->num_conds == GAT_MAX_COND_DEPTH) {
+            gat_fatal_error (ga, GAT_ERR_COND_TOO_DEEP, "conditional nesting too deep");
+        }
+        cond = ga->cond_stack + ga->num_conds++;
+        cond->line_num = ga->line_num;
+        cond->file = ga->file;
+        cond->has_else = 0;
+        if (!valid || ga->num_tokens != num_tokens) {
+            cond->taken = 1;
+        } else {
+            cond->taken = (uint8_t)(token == GAT_IF ? gat_cond_value (ga) : gat_cond_defined (ga));
+        }
+        if (!cond->taken) {
+            ga->cond_skip = 1;
+        }
+        break;
+    case GAT_ELSE:
+        if (ga->num_conds == 0) {
+            gat_error (ga, GAT_ERR_COND_NESTING, "else without if");
+            break;
+        }
+        cond = ga->cond_stack + ga->num_conds - 1;
+        if (cond->has_else) {
+            gat_error (ga, GAT_ERR_COND_NESTING, "else after else");
+        }
+        cond->has_else = 1;
+        if (ga->cond_skip == 0) {
+            ga->cond_skip = 1;
+        } else if (!cond->taken) {
+            cond->taken = 1;
+            ga->cond_skip = 0;
+        }
+        break;
+    case GAT_ENDIF:
+        if (ga->num_conds == 0) {
+            gat_error (ga, GAT_ERR_COND_NESTING, "endif without if");
+            break;
+        }
+        --ga->num_conds;
+        ga->cond_skip = 0;
+        break;
+    }
+}
+
+/* looks at a line of a false block. IFs nested in the block are counted up to 
+   their ENDIF; returns 0 for the ELSE or ENDIF of the block itself, which is 
+   scanned as usual, and 1 if the line is skipped. text is a trimmed line or 
+   the first token of one. */
+int gat_skip_line (gat *ga, const char *text, size_t length) {
+    size_t len = 0;
+    unsigned i;
+
+    while (len < length && len <= GAT_COND_MAX_WORD && gat_ctype_is(text[len], GAT_CC_ID)) {
+        ++len;
+    }
+
+    if (len > 0 && len <= GAT_COND_MAX_WORD) {
+        for (i = 0; i < ga->len_dirt_table; i++) {
+            const gat_dirt *dirt = ga->dirt_table + i;
+
+            if ( dirt->token < GAT_IF || dirt->token > GAT_ENDIF || 
+                 gat_strcmpi_view (dirt->command, text, len) != 0 ) {
+                continue;
+            }
+            if (dirt->token == GAT_IF || dirt->token == GAT_IFDEF) {
+                ++ga->cond_skip;
+            } else if (ga->cond_skip == 1) {
+                return 0;
+            } else if (dirt->token == GAT_ENDIF) {
+                --ga->cond_skip;
+            }
+            break;
+        }
+    }
+
+    ++ga->stats.skipped_lines;
+    return 1;
+}
+
+/* reports IF blocks left open at the end of the source */
+void gat_end_conds (gat *ga) {
+    unsigned i;
+
+    for (i = 0; i < ga->num_conds; i++) {
+        ga->line_num = ga->cond_stack[i].line_num;
+        ga->file = ga->cond_stack[i].file;
+        gat_error (ga, GAT_ERR_COND_NESTING, "if without endif");
+    }
+    gat_cond_reset (ga);
+}
@@ -19,70 +19,84 @@
 /** gat_conv.cpp  gat data conversion routines. */
 #include "gat_conv.h"
 #include "gat_str.h"
-#include <ctype.h>
+#include "gat_ctype.h"
+#include <stdio.h>
 
-/* converts hex token to integer value */
+/* value of a hex digit */
+#define _xdigit_value(_c) ((_c) <= '9' ? (_c) - '0' : ((_c) | 0x20) - 'a' + 10)
+
+/* converts leading hex digits of a string to integer value */
 uint32_t gat_hex_to_num (const char *strtext) {
-    const char *ptr;
     uint32_t value = 0;
-    uint32_t place = 1;
-
-    for (ptr = strtext + strlen(strtext) - 1; ptr >= strtext; ptr--) {
-        if ( isdigit (*ptr) ) {
-            value+= place * (*ptr - '0');
-        } else if ( isxdigit ( *ptr) ) {
-            value+= place * (tolower(*ptr) - 'a' + 10);
-        } else {
-            break;
-        }
-        place*= 16;
+    for (; gat_ctype_is (*strtext, GAT_CC_XDIGIT); strtext++) {
+        value = value * 16 + _xdigit_value (*strtext);
     }
     return value;
 }
 
-/* converts dex token to integer value */
+/* converts leading decimal digits of a string to integer value */
 uint32_t gat_dec_to_num (const char *strtext) {
-    const char *ptr;
     uint32_t value = 0;
-    uint32_t place = 1;
-    for (ptr = strtext + strlen(strtext)-1;  ptr >= strtext; ptr--) {
-        if ( isdigit ( *ptr ) ) {
-            value+= place * (*ptr - '0');
-        } else {
-            break;
-        } 
-        place*= 10;
+    for (; gat_ctype_is (*strtext, GAT_CC_DIGIT); strtext++) {
+        value = value * 10 + (*strtext - '0');
     }
     return value;
 }
 
-/* converts string token to number */
-uint32_t gat_cnum (const char *strtext) {
-    char buff[GAT_MAX_TOKEN_LEN + 1];
-    uint32_t num;
-    char *ptr = (char *)strtext;
-    size_t len = strlen(strtext);
-    uint8_t ishex = 0;
+/* decodes a numeric literal in one forward pass; decimal (127), hex with 0x 
+   prefix (0x7F) or h suffix (7Fh). numbers start with a decimal digit. 
+   returns 0 if the text is not a number. */
+int gat_decode_num (const char *strtext, size_t length, uint32_t *value) {
+    const char *ptr = strtext;
+    const char *end = strtext + length;
+    uint32_t num = 0;
 
-    /* check for a hex notations: 0xFF, FFh */
-    if ( strtext[0] == '0' && tolower(strtext[1]) == 'x' ) {        
-        ishex = 1;
-        ptr+= 2;
-        len-= 2;
-    } else if ( tolower(strtext[len-1]) == 'h' ) {
-        ishex = 1;
-        --len;
+    if ( length == 0 || length > GAT_MAX_NUMERIC_TOKEN_LENGTH || 
+        !gat_ctype_is (*ptr, GAT_CC_DIGIT) ) {
+        return 0;
     }
 
-    /* convert to number */
-    if (ishex) {
-        strncpy (buff, ptr, len);
-        buff[len] = '\0';
-        num = gat_hex_to_num ( buff );
+    if ( length > 2 && ptr[0] == '0' && (ptr[1] | 0x20) == 'x' ) {
+        /* 0xFF */
+        for (ptr+= 2; ptr < end; ptr++) {
+            if ( !gat_ctype_is (*ptr, GAT_CC_XDIGIT) ) {
+                return 0;
+            }
+            num = num * 16 + _xdigit_value (*ptr);
+        }
+    } else if ( (end[-1] | 0x20) == 'h' ) {
+        /* 0FFh */
+        for (--end; ptr < end; ptr++) {
+            if ( !gat_ctype_is (*ptr, GAT_CC_XDIGIT) ) {
+                return 0;
+            }
+            num = num * 16 + _xdigit_value (*ptr);
+        }
     } else {
-        num = gat_dec_to_num ( ptr );
+        for (; ptr < end; ptr++) {
+            if ( !gat_ctype_is (*ptr, GAT_CC_DIGIT) ) {
+                return 0;
+            }
+            num = num * 10 + (*ptr - '0');
+        }
     }
 
+    *value = num;
+    return 1;
+}
+
+/* returns width class of a number value */
+uint8_t gat_num_width (uint32_t value) {
+    if (value <= GAT_MAX_BYTE) {
+        return GAT_NUMW_BYTE;
+    }
+    return value <= GAT_MAX_DBL ? GAT_NUMW_DBL : GAT_NUMW_WIDE;
+}
+
+/* converts string token to number; 0 if it is not a number */
+uint32_t gat_cnum (const char *strtext) {
+    uint32_t num = 0;
+    gat_decode_num (strtext, strlen(strtext), &num);
     return num;
 }
 
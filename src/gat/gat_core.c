@@ -23,42 +23,80 @@
 #include "gat_io.h"
 #include "gat_parser.h"
 #include "gat_tokenizer.h"
+#include "gat_ir.h"
+#include "gat_image.h"
+#include "gat_parallel.h"
+#include "gat_table.h"
+#include "gat_macro.h"
+#include "gat_include.h"
+#include "gat_expr.h"
+#include "gat_cond.h"
 #include "gat_err.h"
-#if defined(__MACH__) || defined(__APPLE__) || defined(__CYGWIN__)
 #include <stdlib.h>
-#else
-#include <malloc.h>
-#include <process.h> /* exit() */
-#endif
 
 /* initializes the assembler */
-void gat_init (gat *ga, gat_arch *arch, gat_dirt *dirt_table, unsigned len_dirt_table, gat_instr *instr_table, unsigned len_instr_table) {
+void gat_init (gat *ga, const gat_arch *arch, const gat_dirt *dirt_table, unsigned len_dirt_table, const gat_instr *instr_table, unsigned len_instr_table) {
+    unsigned i;
+
     ga->callback = NULL;
     ga->context = NULL;
     ga->arch = arch;
 
     ga->fatal_error = 0;
-    ga->num_ids = 0;
-    ga->num_labels = 0;
+    ga->fatal_jmp_armed = 0;
+    gat_symtab_init (ga);
+    gat_macro_init (ga);
+    gat_include_init (ga);
+    gat_expr_init (ga);
+    gat_cond_reset (ga);
 
     ga->err_count = 0;
     ga->warn_count = 0;
+    ga->max_errors = GAT_MAX_ERRORS;
+    ga->include_dir = NULL;
     ga->offset = 0;
     ga->size = 0;
+    ga->max_rec_length = INTEL_MAX_HEX_RECSIZE;
+    ga->engine = GAT_ENGINE_TWO_PASS;
+    ga->stats_enabled = 0;
+    ga->num_pipe_threads = 0;
+    ga->num_threads = 1;
+    ga->workers = NULL;
+    ga->num_workers = 0;
+    memset (&ga->stats, 0, sizeof(gat_stats));
 
     ga->num_ios = 0;
 
+    ga->src = NULL;
+    ga->src_size = 0;
+    ga->src_pos = 0;
+    ga->src_mapped = 0;
+    ga->src_borrowed = 0;
+    ga->line = NULL;
+    ga->line_len = 0;
+
     ga->pass = 0;
     ga->line_num = 0;
     ga->num_tokens = 0;
 
-    memset (ga->arr_tokens, 0, sizeof(ga->arr_tokens));
-    memset (ga->arr_raw_tokens, 0, sizeof(ga->arr_raw_tokens));
+    gat_free_tokens (ga);
+    memset (ga->arr_token_class, 0, sizeof(ga->arr_token_class));
+    gat_ir_init (&ga->ir);
+    ga->image = NULL;
 
     ga->dirt_table = dirt_table;
     ga->len_dirt_table = len_dirt_table;
     ga->instr_table = instr_table;
     ga->len_instr_table = len_instr_table;
+    ga->kw_table = NULL;
+
+    /* directive commands are looked up at token positions up to this */
+    ga->max_dirt_token_index = 0;
+    for (i = 0; i < len_dirt_table; i++) {
+        if (dirt_table[i].token_index > ga->max_dirt_token_index) {
+            ga->max_dirt_token_index = dirt_table[i].token_index;
+        }
+    }
 }
 
 /* sets callback */
@@ -67,36 +105,111 @@ void gat_set_callback (gat *ga, gat_callback callback, void *context) {
     ga->context = context;
 }
 
-/* gat engine function */
+/* selects the engine; GAT_ENGINE_TWO_PASS by default */
+void gat_set_engine (gat *ga, int engine) {
+    ga->engine = engine;
+}
+
+/* enables timing of engine phases in ga->stats */
+void gat_set_stats (gat *ga, int enable) {
+    ga->stats_enabled = enable;
+}
+
+/* sets number of threads reading and tokenizing large sources ahead of 
+   pass #1; 0 to scan serially (the default) */
+void gat_set_pipeline (gat *ga, unsigned num_threads) {
+    ga->num_pipe_threads = num_threads > GAT_PIPE_MAX_THREADS ? GAT_PIPE_MAX_THREADS : num_threads;
+}
+
+/* sets number of threads of the parallel engine stages; 1 runs them serially 
+   (the default) */
+void gat_set_threads (gat *ga, unsigned num_threads) {
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    ga->num_threads = num_threads > GAT_PAR_MAX_THREADS ? GAT_PAR_MAX_THREADS : num_threads;
+}
+
+/* sets the error limit of a source; assembly stops once it is reached. 
+   GAT_MAX_ERRORS by default, 0 for no limit. */
+void gat_set_max_errors (gat *ga, unsigned max_errors) {
+    ga->max_errors = max_errors;
+}
+
+/* sets the directory INCLUDE paths of a source set from memory are taken 
+   from; such a source has no directory of its own. NULL, the default, 
+   rejects INCLUDE there so that no file is read. dir must outlive its use. */
+void gat_set_include_dir (gat *ga, const char *dir) {
+    ga->include_dir = dir;
+}
+
+/* sets the perfect hash keyword table generated for the instruction and 
+   directive tables; without it keywords are searched in the tables. */
+void gat_set_keywords (gat *ga, const gat_kwtable *kw_table) {
+    ga->kw_table = kw_table;
+}
+
+/* gat engine function. returns 0 on success and -1 if the source has errors; 
+   on a fatal error ga->fatal_error holds its error number. */
 int gat_engine (gat *ga) {
+    uint64_t mark[2], emit_wall, emit_cpu;
     int exit_code;
 
+    /* fatal errors raised during the run unwind back here */
+    if (setjmp (ga->fatal_jmp) != 0) {
+        ga->fatal_jmp_armed = 0;
+        return -1;
+    }
+    ga->fatal_jmp_armed = 1;
+
+    gat_stats_mark (ga, mark);
     gat_open_files (ga);
+    gat_stats_phase (ga, GAT_PHASE_OPEN, mark);
+    ga->stats.source_bytes = ga->src_size;
 
     /* run PASS #1 (analysis phase) */  
+    gat_stats_mark (ga, mark);
     ga->pass = 1;
     gat_init_pass (ga);
     gat_scan (ga);
+    gat_stats_phase (ga, GAT_PHASE_PASS1, mark);
+    gat_stats_heap (ga);
         
-    /* run PASS #2 (assembly phase) */
-    ga->pass = 2;
-    gat_init_pass (ga); 
-    gat_assemble (ga);
+    /* emitters are timed on their own; their time is taken out of pass #2 */
+    emit_wall = ga->stats.wall_ns[GAT_PHASE_EMIT];
+    emit_cpu = ga->stats.cpu_ns[GAT_PHASE_EMIT];
+    gat_stats_mark (ga, mark);
+    if (ga->engine == GAT_ENGINE_SINGLE_PASS) {
+        /* code is generated on analysis; fix up forward references and write it */
+        gat_patch_fixups (ga);
+        gat_emit_image (ga);
+    } else {
+        /* run PASS #2 (assembly phase) */
+        ga->pass = 2;
+        gat_init_pass (ga); 
+        gat_assemble (ga);
+    }
+    gat_stats_phase (ga, GAT_PHASE_PASS2, mark);
+    ga->stats.wall_ns[GAT_PHASE_PASS2]-= ga->stats.wall_ns[GAT_PHASE_EMIT] - emit_wall;
+    ga->stats.cpu_ns[GAT_PHASE_PASS2]-= ga->stats.cpu_ns[GAT_PHASE_EMIT] - emit_cpu;
+    gat_stats_heap (ga);
 
     /* print assembly / error report */
-    if (ga->err_count == 0) {
+    if (ga->err_count == 0 && ga->num_ios > 1) {
         gat_print (ga, "written %u bytes to %s", ga->size, ga->ios[1].path);
     }
     gat_print (ga, "%u error(s) %u warning(s)", ga->err_count, ga->warn_count);
 
+    ga->fatal_jmp_armed = 0;
     exit_code = (ga->err_count == 0 ? 0 : -1);
     return exit_code;
 }
 
-/* cleanup assembly state */
-void gat_cleanup (gat *ga) {
-    gat_free_tokens (ga);
+/* closes files of the current source; output files are deleted on error */
+void gat_close (gat *ga) {
+    uint64_t mark[2];
 
+    gat_stats_mark (ga, mark);
     gat_close_files (ga);
 
     /* delete ouput files on error */
@@ -107,12 +220,60 @@ void gat_cleanup (gat *ga) {
             gat_kill_file (ga, io->path);
         }
     }
+    gat_stats_phase (ga, GAT_PHASE_CLEANUP, mark);
+}
+
+/* prepares the assembler for the next source. tables, callback, options and 
+   allocated memory are kept for reuse; io channels must be attached again. */
+void gat_reset (gat *ga) {
+    gat_close_files (ga);
+    ga->num_ios = 0;
+
+    ga->fatal_error = 0;
+    ga->fatal_jmp_armed = 0;
+    ga->err_count = 0;
+    ga->warn_count = 0;
+    ga->org = 0;
+    ga->offset = 0;
+    ga->size = 0;
+    ga->pass = 0;
+    ga->line_num = 0;
+
+    gat_free_tokens (ga);
+    gat_ir_reset (&ga->ir);
+    gat_symtab_reset (ga);
+    gat_macro_reset (ga);
+    gat_include_reset (ga);
+    gat_expr_reset (ga);
+    gat_cond_reset (ga);
+    memset (&ga->stats, 0, sizeof(gat_stats));
+}
+
+/* cleanup assembly state */
+void gat_cleanup (gat *ga) {
+    gat_free_tokens (ga);
+    gat_ir_free (&ga->ir);
+    gat_image_free (ga);
+    gat_par_free (ga);
+    gat_symtab_free (ga);
+    gat_macro_free (ga);
+    gat_include_free (ga);
+    gat_expr_free (ga);
+
+    gat_close (ga);
 }
 
 /* initializes a pass state */
 void gat_init_pass (gat *ga) {
     gat_free_tokens (ga);
     ga->line_num = 0;
+    ga->file = 0;
+
+    /* analysis phase builds the line IR afresh */
+    if (ga->pass == 1) {
+        gat_ir_reset (&ga->ir);
+        gat_expr_reset (ga);
+    }
 }
 
 /* prints message on screen. masm85 doesn't directly print on the stdout or FILE.
@@ -122,111 +283,95 @@ void gat_print (gat *ga, const char *format, ...) {
         if (format == NULL) {
             ga->callback (ga, GAT_CALLBACK_TEXT, "", ga->context);
         } else {
-            char *buff;
             va_list arg_list;
 
+            /* format in the context buffer; no allocation per message */
             va_start (arg_list, format);
-            buff = gat_format_string  (format, arg_list);
+            gat_format_buff (ga->msg_buff, sizeof(ga->msg_buff), format, arg_list);
             va_end (arg_list);
 
             /* redirect message to callback if it is set */
-            ga->callback (ga, GAT_CALLBACK_TEXT, buff, ga->context);
-        
-            free (buff);
+            ga->callback (ga, GAT_CALLBACK_TEXT, ga->msg_buff, ga->context);
         }       
     }   
 }
 
-/* prints non-fatal error message */
-void gat_error (gat *ga, int err_no, const char *format, ...) {
+/* formats error description in the context buffer and reports the error 
+   record to the callback. the description is valid during the callback. */
+static void gat_report (gat *ga, int err_no, int warning, int fatal, 
+                        const char *format, va_list arg_list) {
     gat_error_info err;
-    char *err_desc;
-    va_list arg_list;
 
-    /* increment error count */
-    ++ga->err_count;
+    if (ga->callback == NULL) {
+        return;
+    }
 
-    if (ga->callback != NULL) {
-        /* build error description string */    
-        va_start (arg_list, format);
-        err_desc = gat_format_string  (format, arg_list);
-        va_end (arg_list);
+    gat_format_buff (ga->msg_buff, sizeof(ga->msg_buff), format, arg_list);
 
-        /* build error info */
-        err.warning = 0; /* error */
-        err.fatal = 0;
-        err.errno = err_no;
-        err.desc = err_desc;
-        err.file = ga->ios[0].path;
-        err.line = ga->line_num;
-        err.col = -1;
+    /* build error info */
+    err.warning = (uint8_t)warning;
+    err.fatal = (uint8_t)fatal;
+    err.errno = err_no;
+    err.desc = ga->msg_buff;
+    err.file = (char *)gat_file_path (ga, ga->file);
+    err.line = ga->line_num;
+    err.col = -1;
 
-        /* report error */
-        ga->callback (ga, GAT_CALLBACK_ERROR, &err, ga->context);
+    ga->callback (ga, GAT_CALLBACK_ERROR, &err, ga->context);
+}
 
-        /* free error desccription string */
-        free (err_desc);
+/* stops the running engine once the error limit is reached */
+static void gat_check_error_limit (gat *ga) {
+    if (ga->max_errors > 0 && ga->err_count >= ga->max_errors && ga->fatal_jmp_armed) {
+        gat_fatal_error (ga, GAT_ERR_TOO_MANY_ERRORS, 
+                         "too many errors (%u); assembly stopped", ga->err_count);
     }
 }
 
-void gat_warning (gat *ga, int err_no, const char *format, ...) {
-    gat_error_info err;
-    char *err_desc;
+/* prints non-fatal error message */
+void gat_error (gat *ga, int err_no, const char *format, ...) {
     va_list arg_list;
 
     /* increment error count */
-    ++ga->warn_count;
+    ++ga->err_count;
 
-    if (ga->callback != NULL) {
-        /* build error description string */    
-        va_start (arg_list, format);
-        err_desc = gat_format_string  (format, arg_list);
-        va_end (arg_list);
+    va_start (arg_list, format);
+    gat_report (ga, err_no, 0, 0, format, arg_list);
+    va_end (arg_list);
 
-        /* build error info */
-        err.warning = 1;
-        err.fatal = 0;
-        err.errno = err_no;
-        err.desc = err_desc;
-        err.file =  ga->ios[0].path;
-        err.line = ga->line_num;
-        err.col = -1;
+    gat_check_error_limit (ga);
+}
 
-        /* report error */
-        ga->callback (ga, GAT_CALLBACK_ERROR, &err, ga->context);
+void gat_warning (gat *ga, int err_no, const char *format, ...) {
+    va_list arg_list;
 
-        /* free error desccription string */
-        free (err_desc);
-    }
+    /* increment warning count */
+    ++ga->warn_count;
+
+    va_start (arg_list, format);
+    gat_report (ga, err_no, 1, 0, format, arg_list);
+    va_end (arg_list);
 }
 
-/* gat_fatal_error does fatal error reporting, performs proper cleanup and exits 
-   the assembler. Note that this sub routine does not return. */
+/* gat_fatal_error does fatal error reporting. Within gat_engine it unwinds the 
+   run and gat_engine returns; the caller closes the source as usual. Outside 
+   the engine it performs proper cleanup and exits the assembler. Note that this 
+   sub routine does not return. */
 void gat_fatal_error (gat *ga, int err_no, const char *format, ...) {
-    gat_error_info err;
-    char *err_desc;
     va_list arg_list;
 
-    ga->fatal_error = 1;
-    ++ga->err_count;
-
-    if (ga->callback != NULL) {
-        va_start (arg_list, format);
-        err_desc = gat_format_string  (format, arg_list);
-        va_end (arg_list);
-
-        /* build error info */
-        err.warning = 0; /* error */
-        err.fatal = 1;
-        err.errno = err_no;
-        err.desc = err_desc;
-        err.file =  ga->ios[0].path;
-        err.line = ga->line_num;
-        err.col = -1;
+    ga->fatal_error = err_no;
+    if (err_no != GAT_ERR_TOO_MANY_ERRORS) {
+        ++ga->err_count;
+    }
 
-        ga->callback (ga, GAT_CALLBACK_ERROR, &err, ga->context);
+    va_start (arg_list, format);
+    gat_report (ga, err_no, 0, 1, format, arg_list);
+    va_end (arg_list);
 
-        free (err_desc);
+    /* unwind the running engine */
+    if (ga->fatal_jmp_armed) {
+        longjmp (ga->fatal_jmp, 1);
     }
 
     /* perform cleanup and exit */
@@ -235,3 +380,103 @@ void gat_fatal_error (gat *ga, int err_no, const char *format, ...) {
     /* terminate through exit */
     exit (err_no);
 }
+
+/* marks the start of a phase when stats are enabled */
+void gat_stats_mark (gat *ga, uint64_t mark[2]) {
+    if (ga->stats_enabled) {
+        gat_clock (&mark[0], &mark[1]);
+    }
+}
+
+/* adds time since mark to the phase when stats are enabled */
+void gat_stats_phase (gat *ga, int phase, const uint64_t mark[2]) {
+    if (ga->stats_enabled) {
+        uint64_t wall_ns, cpu_ns;
+        gat_clock (&wall_ns, &cpu_ns);
+        ga->stats.wall_ns[phase]+= wall_ns - mark[0];
+        ga->stats.cpu_ns[phase]+= cpu_ns - mark[1];
+    }
+}
+
+/* updates peak heap with the memory the context holds now. arrays only grow 
+   during a source, so sampling at the end of each pass finds the peak. */
+void gat_stats_heap (gat *ga) {
+    uint64_t heap = 0;
+    unsigned i;
+
+    heap+= (uint64_t)ga->symtab.num_slots * sizeof(gat_symbol);
+    heap+= ga->symtab.max_names_size;
+    heap+= (uint64_t)ga->max_ids * sizeof(gat_id);
+    heap+= (uint64_t)ga->max_labels * sizeof(gat_label);
+    heap+= (uint64_t)ga->max_macros * sizeof(gat_macro);
+    heap+= (uint64_t)ga->max_macro_lines * sizeof(gat_macro_line);
+    heap+= (uint64_t)ga->max_macro_tokens * sizeof(gat_macro_token);
+    heap+= (uint64_t)ga->max_includes * sizeof(gat_incl_file *);
+    heap+= (uint64_t)ga->max_expr_ops * sizeof(gat_expr_op);
+    heap+= ga->max_expr_names_size;
+    heap+= (uint64_t)ga->ir.max_lines * sizeof(gat_line);
+    heap+= (uint64_t)ga->ir.max_tokens * sizeof(gat_ir_token);
+    heap+= (uint64_t)ga->ir.max_fixups * sizeof(unsigned);
+    if (ga->image != NULL) {
+        heap+= sizeof(gat_image);
+    }
+    heap+= (uint64_t)ga->num_workers * (sizeof(gat_par_worker) + sizeof(gat));
+    for (i = 0; i < ga->num_workers; i++) {
+        heap+= (uint64_t)ga->workers[i].ir.max_lines * sizeof(gat_line);
+        heap+= (uint64_t)ga->workers[i].ir.max_tokens * sizeof(gat_ir_token);
+    }
+    if (ga->src != NULL && !ga->src_mapped) {
+        heap+= ga->src_size;
+    }
+    if (heap > ga->stats.peak_heap) {
+        ga->stats.peak_heap = heap;
+    }
+}
+
+/* adds stats of a source to the totals; peak heap is the largest seen */
+void gat_stats_add (gat_stats *total, const gat_stats *stats) {
+    int i;
+
+    for (i = 0; i < GAT_NUM_PHASES; i++) {
+        total->wall_ns[i]+= stats->wall_ns[i];
+        total->cpu_ns[i]+= stats->cpu_ns[i];
+    }
+    total->source_bytes+= stats->source_bytes;
+    total->lines+= stats->lines;
+    total->tokens+= stats->tokens;
+    total->sym_lookups+= stats->sym_lookups;
+    total->sym_probes+= stats->sym_probes;
+    total->kw_lookups+= stats->kw_lookups;
+    total->macro_expansions+= stats->macro_expansions;
+    total->macro_lines+= stats->macro_lines;
+    total->includes+= stats->includes;
+    total->include_hits+= stats->include_hits;
+    total->skipped_lines+= stats->skipped_lines;
+    total->emit_calls+= stats->emit_calls;
+    total->emit_bytes+= stats->emit_bytes;
+    if (stats->peak_heap > total->peak_heap) {
+        total->peak_heap = stats->peak_heap;
+    }
+}
+
+/* grows a dynamic array to hold at least count elements. capacity doubles 
+   starting from init_capacity. */
+void *gat_grow (gat *ga, void *arr, size_t elem_size, size_t count, 
+                size_t *capacity, size_t init_capacity) {
+    size_t new_capacity;
+    void *temp;
+
+    if (count <= *capacity) {
+        return arr;
+    }
+    new_capacity = *capacity == 0 ? init_capacity : *capacity;
+    while (new_capacity < count) {
+        new_capacity*= 2;
+    }
+    temp = realloc (arr, new_capacity * elem_size);
+    if (temp == NULL) {
+        gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+    }
+    *capacity = new_capacity;
+    return temp;
+}
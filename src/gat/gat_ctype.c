@@ -0,0 +1,167 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_ctype.c  character classification table and delimiter scanner for the lexer. */
+#include "gat_ctype.h"
+
+/* use SSE2 / AVX2 intrinsics when the compiler targets them */
+#if defined(__AVX2__)
+#define GAT_SCAN_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GAT_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#define _W      GAT_CC_WHITE
+#define _S      GAT_CC_SYMBOL
+#define _Q      GAT_CC_QUOTE
+#define _C      GAT_CC_COMMENT
+#define _D      GAT_CC_DIGIT
+#define _X      GAT_CC_XDIGIT
+#define _I      GAT_CC_ID
+
+/* built from GAT_WHITE and GAT_SYMBOLS. '\0' is both white and a symbol as 
+   strchr() used to report it. */
+const uint8_t gat_ctype_table[256] = {
+    _W|_S, 0, 0, 0, 0, 0, 0, 0,
+    0, _W, _W, _W, _W, _W, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    _W, _S, _S|_Q, _S, _S, _S, _S, _S,
+    _S, _S, _S, _S, _S, _S, _S, _S,
+    _D|_X|_I, _D|_X|_I, _D|_X|_I, _D|_X|_I, _D|_X|_I, _D|_X|_I, _D|_X|_I, _D|_X|_I,
+    _D|_X|_I, _D|_X|_I, _S, _S|_C, _S, _S, _S, _S,
+    _S, _X|_I, _X|_I, _X|_I, _X|_I, _X|_I, _X|_I, _I,
+    _I, _I, _I, _I, _I, _I, _I, _I,
+    _I, _I, _I, _I, _I, _I, _I, _I,
+    _I, _I, _I, _S, _S, _S, _S, _I,
+    0, _X|_I, _X|_I, _X|_I, _X|_I, _X|_I, _X|_I, _I,
+    _I, _I, _I, _I, _I, _I, _I, _I,
+    _I, _I, _I, _I, _I, _I, _I, _I,
+    _I, _I, _I, _S, _S, _S, _S, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#undef _W
+#undef _S
+#undef _Q
+#undef _C
+#undef _D
+#undef _X
+#undef _I
+
+/* delimiters are '\0', [\t-\r], [ -/], [:-@], [[-^] and [{-~]; all of them 
+   are below 0x80 so signed byte compares work. */
+#if defined(GAT_SCAN_AVX2) || defined(GAT_SCAN_SSE2)
+/* index of the lowest set bit of a non zero mask */
+static unsigned gat_lowest_bit (unsigned mask) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz (mask);
+#else
+    unsigned i = 0;
+    while ( !(mask & 1) ) {
+        mask>>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+#endif
+
+#if defined(GAT_SCAN_AVX2)
+
+#define _in_range(_v,_lo,_hi) _mm256_and_si256 ( \
+    _mm256_cmpgt_epi8 ((_v), _mm256_set1_epi8 ((char)((_lo) - 1))), \
+    _mm256_cmpgt_epi8 (_mm256_set1_epi8 ((char)((_hi) + 1)), (_v)) )
+
+const char *gat_scan_delim (const char *head, const char *end) {
+    while (end - head >= 32) {
+        __m256i v = _mm256_loadu_si256 ((const __m256i *)head);
+        __m256i m = _mm256_cmpeq_epi8 (v, _mm256_setzero_si256 ());
+        unsigned mask;
+        m = _mm256_or_si256 (m, _in_range (v, 0x09, 0x0D));
+        m = _mm256_or_si256 (m, _in_range (v, 0x20, 0x2F));
+        m = _mm256_or_si256 (m, _in_range (v, 0x3A, 0x40));
+        m = _mm256_or_si256 (m, _in_range (v, 0x5B, 0x5E));
+        m = _mm256_or_si256 (m, _in_range (v, 0x7B, 0x7E));
+        mask = (unsigned)_mm256_movemask_epi8 (m);
+        if (mask) {
+            return head + gat_lowest_bit (mask);
+        }
+        head+= 32;
+    }
+    while (head < end && !gat_ctype_is (*head, GAT_CC_DELIM)) {
+        ++head;
+    }
+    return head;
+}
+
+#elif defined(GAT_SCAN_SSE2)
+
+#define _in_range(_v,_lo,_hi) _mm_and_si128 ( \
+    _mm_cmpgt_epi8 ((_v), _mm_set1_epi8 ((char)((_lo) - 1))), \
+    _mm_cmplt_epi8 ((_v), _mm_set1_epi8 ((char)((_hi) + 1))) )
+
+const char *gat_scan_delim (const char *head, const char *end) {
+    while (end - head >= 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i *)head);
+        __m128i m = _mm_cmpeq_epi8 (v, _mm_setzero_si128 ());
+        unsigned mask;
+        m = _mm_or_si128 (m, _in_range (v, 0x09, 0x0D));
+        m = _mm_or_si128 (m, _in_range (v, 0x20, 0x2F));
+        m = _mm_or_si128 (m, _in_range (v, 0x3A, 0x40));
+        m = _mm_or_si128 (m, _in_range (v, 0x5B, 0x5E));
+        m = _mm_or_si128 (m, _in_range (v, 0x7B, 0x7E));
+        mask = (unsigned)_mm_movemask_epi8 (m);
+        if (mask) {
+            return head + gat_lowest_bit (mask);
+        }
+        head+= 16;
+    }
+    while (head < end && !gat_ctype_is (*head, GAT_CC_DELIM)) {
+        ++head;
+    }
+    return head;
+}
+
+#else
+
+const char *gat_scan_delim (const char *head, const char *end) {
+    while (head < end && !gat_ctype_is (*head, GAT_CC_DELIM)) {
+        ++head;
+    }
+    return head;
+}
+
+#endif
@@ -0,0 +1,567 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_expr.c  operand expressions. an operand of several tokens is compiled 
+    into postfix code when its line is scanned; subexpressions of constants 
+    are folded as they are compiled. an expression left with symbols keeps 
+    its code and is evaluated when the operand is parsed, once the symbols 
+    are defined. values are signed; each result must fit a word taken as 
+    signed or unsigned, and negatives are stored as two's complement. */
+#include "gat_expr.h"
+#include "gat_core.h"
+#include "gat_lexer.h"
+#include "gat_parser.h"
+#include "gat_conv.h"
+#include "gat_table.h"
+#include "gat_tokenizer.h"
+#include "gat_err.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* initial capacities; arrays double from here */
+#define GAT_EXPR_INIT_OPS           256
+#define GAT_EXPR_INIT_NAMES         1024
+
+/* expression being compiled from tokens [pos, end) of the current line */
+typedef struct _gat_expr_parser {
+    gat *ga;
+    unsigned pos;
+    unsigned end;
+    int status;                 /* of a fold that failed; see gat_expr_apply */
+    gat_expr_op ops [GAT_MAX_TOKENS + 1];   /* a symbol op holds its token index */
+    unsigned num_ops;
+}gat_expr_parser;
+
+void gat_expr_init (gat *ga) {
+    ga->expr_ops = NULL;
+    ga->num_expr_ops = 0;
+    ga->max_expr_ops = 0;
+    ga->expr_names = NULL;
+    ga->expr_names_size = 0;
+    ga->max_expr_names_size = 0;
+    ga->expr_texts = NULL;
+}
+
+static void gat_expr_free_texts (gat_expr_texts *block) {
+    while (block != NULL) {
+        gat_expr_texts *next = block->next;
+        free (block);
+        block = next;
+    }
+}
+
+/* removes all expression code keeping allocated memory; the newest text 
+   block is kept */
+void gat_expr_reset (gat *ga) {
+    ga->num_expr_ops = 0;
+    ga->expr_names_size = 0;
+    if (ga->expr_texts != NULL) {
+        gat_expr_free_texts (ga->expr_texts->next);
+        ga->expr_texts->next = NULL;
+        ga->expr_texts->size = 0;
+    }
+}
+
+void gat_expr_free (gat *ga) {
+    free (ga->expr_ops);
+    free (ga->expr_names);
+    gat_expr_free_texts (ga->expr_texts);
+    gat_expr_init (ga);
+}
+
+/* tests if token at index is the symbol ch */
+static int gat_expr_is_sym (gat *ga, unsigned index, char ch) {
+    const gat_token *token = &ga->arr_raw_tokens[index];
+    return token->type == GAT_TOK_SYMBOL && token->length == 1 && token->string[0] == ch;
+}
+
+/* applies op to a, or to a and b. returns 1, 0 on division by zero and -1 
+   if the result does not fit a word */
+static int gat_expr_apply (uint8_t op, int32_t a, int32_t b, int32_t *result) {
+    int64_t r = 0;
+
+    switch (op) {
+    case GAT_EXPR_NEG:  r = -(int64_t)a; break;
+    case GAT_EXPR_NOT:  r = ~(int64_t)a; break;
+    case GAT_EXPR_HIGH: r = ((uint32_t)a & 0xFFFF) >> 8; break;
+    case GAT_EXPR_LOW:  r = (uint32_t)a & 0x00FF; break;
+    case GAT_EXPR_MUL:  r = (int64_t)a * b; break;
+    case GAT_EXPR_DIV:
+        if (b == 0) {
+            return 0;
+        }
+        r = a / b; break;
+    case GAT_EXPR_MOD:
+        if (b == 0) {
+            return 0;
+        }
+        r = a % b; break;
+    case GAT_EXPR_ADD:  r = (int64_t)a + b; break;
+    case GAT_EXPR_SUB:  r = (int64_t)a - b; break;
+    case GAT_EXPR_SHL:
+        if (b < 0) {
+            return -1;
+        }
+        /* a value other than 0 shifted past 16 bits can't fit */
+        r = a == 0 ? 0 : (b > 16 ? GAT_MAX_DBL + 1 : (int64_t)a * ((int64_t)1 << b));
+        break;
+    case GAT_EXPR_SHR:
+        if (b < 0) {
+            return -1;
+        }
+        /* shifts the sign in */
+        b = b > 16 ? 16 : b;
+        r = a < 0 ? ~(~a >> b) : a >> b;
+        break;
+    case GAT_EXPR_AND:  r = a & b; break;
+    case GAT_EXPR_XOR:  r = a ^ b; break;
+    case GAT_EXPR_OR:   r = a | b; break;
+    }
+    if (r < GAT_MIN_DBL || r > GAT_MAX_DBL) {
+        return -1;
+    }
+    *result = (int32_t)r;
+    return 1;
+}
+
+/* reports a status of gat_expr_apply other than 1 for expression text */
+static void gat_expr_failed (gat *ga, int status, const char *text, size_t length) {
+    gat_error (ga, GAT_ERR_INVALID_EXPR, "%s : %.*s", 
+                status == 0 ? "division by zero" : "value out of range", (int)length, text);
+}
+
+#define gat_expr_is_unary(_op) ((_op) >= GAT_EXPR_NEG && (_op) <= GAT_EXPR_LOW)
+
+/* appends op to the code; folds it when its operands are constants */
+static int gat_expr_emit (gat_expr_parser *p, uint8_t op) {
+    gat_expr_op *top = p->ops + p->num_ops - 1;
+
+    if (gat_expr_is_unary(op)) {
+        if (top->op == GAT_EXPR_CONST) {
+            p->status = gat_expr_apply (op, top->value, 0, &top->value);
+            return p->status == 1;
+        }
+    } else if (top->op == GAT_EXPR_CONST && top[-1].op == GAT_EXPR_CONST) {
+        p->status = gat_expr_apply (op, top[-1].value, top->value, &top[-1].value);
+        --p->num_ops;
+        return p->status == 1;
+    }
+
+    top = p->ops + p->num_ops++;
+    top->op = op;
+    top->value = 0;
+    top->name = 0;
+    return 1;
+}
+
+static int gat_expr_binary (gat_expr_parser *p, int min_level);
+
+/* primary -> number | id | ( expr ) */
+static int gat_expr_primary (gat_expr_parser *p) {
+    gat *ga = p->ga;
+    gat_expr_op *op;
+
+    if (p->pos >= p->end) {
+        return 0;
+    }
+    if (gat_expr_is_sym (ga, p->pos, '(')) {
+        ++p->pos;
+        if (!gat_expr_binary (p, 0) || p->pos >= p->end || !gat_expr_is_sym (ga, p->pos, ')')) {
+            return 0;
+        }
+        ++p->pos;
+        return 1;
+    }
+
+    op = p->ops + p->num_ops;
+    if (gat_token_is_dbl(ga, p->pos)) {
+        op->op = GAT_EXPR_CONST;
+        op->value = (int32_t)gat_token_value(ga, p->pos);
+    } else if (ga->arr_raw_tokens[p->pos].type == GAT_TOK_WORD && 
+               gat_is_id (gat_token_str(ga, p->pos))) {
+        op->op = GAT_EXPR_SYMBOL;
+        op->value = 0;
+        op->name = p->pos;
+    } else {
+        return 0;
+    }
+    ++p->num_ops;
+    ++p->pos;
+    return 1;
+}
+
+/* unary -> ( - | + | ~ | HIGH | LOW ) unary | primary */
+static int gat_expr_unary (gat_expr_parser *p) {
+    gat *ga = p->ga;
+    const gat_token *token;
+    uint8_t op;
+
+    if (p->pos >= p->end) {
+        return 0;
+    }
+    token = &ga->arr_raw_tokens[p->pos];
+    if (gat_expr_is_sym (ga, p->pos, '-')) {
+        op = GAT_EXPR_NEG;
+    } else if (gat_expr_is_sym (ga, p->pos, '~')) {
+        op = GAT_EXPR_NOT;
+    } else if (gat_expr_is_sym (ga, p->pos, '+')) {
+        op = GAT_EXPR_END;
+    } else if (token->type == GAT_TOK_WORD && gat_token_equi (token, "high")) {
+        op = GAT_EXPR_HIGH;
+    } else if (token->type == GAT_TOK_WORD && gat_token_equi (token, "low")) {
+        op = GAT_EXPR_LOW;
+    } else {
+        return gat_expr_primary (p);
+    }
+
+    ++p->pos;
+    if (!gat_expr_unary (p)) {
+        return 0;
+    }
+    return op == GAT_EXPR_END ? 1 : gat_expr_emit (p, op);
+}
+
+/* returns the precedence level of the binary operator at the current token, 
+   lowest first, or -1 if there is none */
+static int gat_expr_binop (gat_expr_parser *p, uint8_t *op, unsigned *length) {
+    gat *ga = p->ga;
+    const gat_token *token;
+
+    if (p->pos >= p->end) {
+        return -1;
+    }
+    token = &ga->arr_raw_tokens[p->pos];
+    if (token->type != GAT_TOK_SYMBOL || token->length != 1) {
+        return -1;
+    }
+
+    *length = 1;
+    switch (token->string[0]) {
+    case '|': *op = GAT_EXPR_OR; return 0;
+    case '^': *op = GAT_EXPR_XOR; return 1;
+    case '&': *op = GAT_EXPR_AND; return 2;
+    case '<':
+    case '>':
+        /* shifts are two tokens */
+        if (p->pos + 1 >= p->end || !gat_expr_is_sym (ga, p->pos + 1, token->string[0])) {
+            return -1;
+        }
+        *op = token->string[0] == '<' ? GAT_EXPR_SHL : GAT_EXPR_SHR;
+        *length = 2;
+        return 3;
+    case '+': *op = GAT_EXPR_ADD; return 4;
+    case '-': *op = GAT_EXPR_SUB; return 4;
+    case '*': *op = GAT_EXPR_MUL; return 5;
+    case '/': *op = GAT_EXPR_DIV; return 5;
+    case '%': *op = GAT_EXPR_MOD; return 5;
+    }
+    return -1;
+}
+
+/* binary -> unary { op binary } with operators of min_level or above */
+static int gat_expr_binary (gat_expr_parser *p, int min_level) {
+    uint8_t op = 0;
+    unsigned length = 0;
+    int level;
+
+    if (!gat_expr_unary (p)) {
+        return 0;
+    }
+    while ((level = gat_expr_binop (p, &op, &length)) >= min_level) {
+        p->pos+= length;
+        if (!gat_expr_binary (p, level + 1) || !gat_expr_emit (p, op)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* text of tokens [first, last) for messages and for the token they are 
+   replaced by. tokens of a line expanded from a macro come from the body and 
+   from the arguments, which may lie on other lines or in other files; their 
+   text is rebuilt from the tokens, a blank apart, in the text blocks. */
+static const char *gat_expr_text (gat *ga, unsigned first, unsigned last, size_t *length) {
+    const gat_token *head = &ga->arr_raw_tokens[first];
+    const gat_token *tail = &ga->arr_raw_tokens[last - 1];
+    const char *end = tail->string + tail->length;
+    gat_expr_texts *block = ga->expr_texts;
+    char *text;
+    size_t size = 0, n;
+    unsigned i;
+
+    /* otherwise the tokens are slices of one source line, in order */
+    if ( ga->macro_depth == 0 && end > head->string && 
+         (size_t)(end - head->string) <= GAT_MAX_LINEBUFF_SIZE ) {
+        *length = end - head->string;
+        return head->string;
+    }
+
+    if (block == NULL || block->size + GAT_MAX_LINEBUFF_SIZE > GAT_EXPR_TEXT_BLOCK_SIZE) {
+        block = (gat_expr_texts *)malloc (sizeof(gat_expr_texts));
+        if (block == NULL) {
+            gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+        }
+        block->next = ga->expr_texts;
+        block->size = 0;
+        ga->expr_texts = block;
+    }
+
+    text = block->text + block->size;
+    for (i = first; i < last && size < GAT_MAX_LINEBUFF_SIZE; i++) {
+        if (i > first) {
+            text[size++] = ' ';
+        }
+        n = ga->arr_raw_tokens[i].length;
+        if (n > GAT_MAX_LINEBUFF_SIZE - size) {
+            n = GAT_MAX_LINEBUFF_SIZE - size;
+        }
+        memcpy (text + size, ga->arr_raw_tokens[i].string, n);
+        size+= n;
+    }
+    block->size+= size;
+    *length = size;
+    return text;
+}
+
+/* compiles tokens [first, last) of the current line; reports an invalid 
+   expression */
+static int gat_expr_compile (gat *ga, unsigned first, unsigned last, gat_expr_parser *p) {
+    const char *text;
+    size_t length;
+
+    p->ga = ga;
+    p->pos = first;
+    p->end = last;
+    p->status = 1;
+    p->num_ops = 0;
+
+    if (gat_expr_binary (p, 0) && p->pos == last) {
+        p->ops[p->num_ops].op = GAT_EXPR_END;
+        return 1;
+    }
+
+    text = gat_expr_text (ga, first, last, &length);
+    if (p->status != 1) {
+        gat_expr_failed (ga, p->status, text, length);
+    } else {
+        gat_error (ga, GAT_ERR_INVALID_EXPR, "invalid expression : %.*s", (int)length, text);
+    }
+    return 0;
+}
+
+/* looks a symbol up as a label, then as an id. a byte id above 0FFh was 
+   defined from a negative byte. */
+static int gat_expr_symbol (gat *ga, const char *name, int32_t *value) {
+    int index = gat_search_label (ga, name);
+
+    if (index != -1) {
+        *value = ga->arr_labels[index].address;
+        return 1;
+    }
+    index = gat_search_id (ga, name);
+    if (index != -1) {
+        *value = ga->arr_ids[index].data;
+        if (ga->arr_ids[index].idtype == GAT_IDTYPE_BYTE && *value > GAT_MAX_BYTE) {
+            *value-= GAT_MAX_DBL + 1;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/* runs code up to its END op. symbol names are taken from the expression 
+   names, or from the tokens of the current line if names is NULL; text is 
+   the expression for messages. */
+static int gat_expr_run (gat *ga, const gat_expr_op *ops, const char *names, 
+                         const char *text, size_t length, int32_t *value) {
+    int32_t stack [GAT_MAX_TOKENS];
+    unsigned sp = 0;
+    int status;
+
+    for (; ops->op != GAT_EXPR_END; ops++) {
+        switch (ops->op) {
+        case GAT_EXPR_CONST:
+            stack[sp++] = ops->value;
+            break;
+        case GAT_EXPR_SYMBOL: {
+            const char *name = names ? names + ops->name : gat_token_str(ga, ops->name);
+            if (!gat_expr_symbol (ga, name, stack + sp)) {
+                gat_error (ga, GAT_ERR_UNDEFINED_ID, "undefined label or identifier : %s", name);
+                return 0;
+            }
+            ++sp;
+            break;
+        }
+        default:
+            if (gat_expr_is_unary(ops->op)) {
+                status = gat_expr_apply (ops->op, stack[sp - 1], 0, stack + sp - 1);
+            } else {
+                --sp;
+                status = gat_expr_apply (ops->op, stack[sp - 1], stack[sp], stack + sp - 1);
+            }
+            if (status != 1) {
+                gat_expr_failed (ga, status, text, length);
+                return 0;
+            }
+        }
+    }
+    *value = stack[0];
+    return 1;
+}
+
+/* appends compiled code to the expression code; returns index of its first op */
+static unsigned gat_expr_store (gat *ga, const gat_expr_parser *p) {
+    unsigned first = ga->num_expr_ops, i;
+    size_t capacity = ga->max_expr_ops;
+
+    ga->expr_ops = (gat_expr_op *)gat_grow (ga, ga->expr_ops, sizeof(gat_expr_op), 
+                                            first + p->num_ops + 1, &capacity, 
+                                            GAT_EXPR_INIT_OPS);
+    ga->max_expr_ops = (unsigned)capacity;
+
+    for (i = 0; i <= p->num_ops; i++) {
+        gat_expr_op *op = ga->expr_ops + ga->num_expr_ops++;
+
+        *op = p->ops[i];
+        if (op->op == GAT_EXPR_SYMBOL) {
+            const gat_token *token = &ga->arr_raw_tokens[op->name];
+
+            capacity = ga->max_expr_names_size;
+            ga->expr_names = (char *)gat_grow (ga, ga->expr_names, 1, 
+                                               ga->expr_names_size + token->length + 1, 
+                                               &capacity, GAT_EXPR_INIT_NAMES);
+            ga->max_expr_names_size = capacity;
+
+            op->name = (uint32_t)ga->expr_names_size;
+            memcpy (ga->expr_names + ga->expr_names_size, token->string, token->length);
+            ga->expr_names_size+= token->length;
+            ga->expr_names[ga->expr_names_size++] = '\0';
+        }
+    }
+    return first;
+}
+
+/* replaces tokens [first, last) of the current line by token */
+static void gat_expr_collapse (gat *ga, unsigned first, unsigned last, const gat_token *token) {
+    unsigned i;
+
+    ga->arr_raw_tokens[first] = *token;
+    memmove (ga->arr_raw_tokens + first + 1, ga->arr_raw_tokens + last, 
+             (ga->num_tokens - last) * sizeof(gat_token));
+    ga->num_tokens-= last - first - 1;
+
+    for (i = first; i < ga->num_tokens; i++) {
+        ga->arr_tokens[i] = NULL;
+        ga->arr_token_class[i] = GAT_OPCLASS_NONE;
+    }
+}
+
+/* makes a number token of value for expression text; a negative value is 
+   held as a word in two's complement and is a byte from -128 */
+static void gat_expr_number (const char *text, size_t length, int32_t value, 
+                             gat_token *token) {
+    token->string = text;
+    token->length = length;
+    token->type = GAT_TOK_WORD;
+    token->num_value = (uint32_t)value & GAT_MAX_DBL;
+    token->num_width = value < 0 && value >= GAT_MIN_BYTE ? GAT_NUMW_BYTE 
+                                                          : gat_num_width (token->num_value);
+}
+
+/* compiles the operands of the instruction on the current line that span 
+   several tokens into one token each: a number if the expression is 
+   constant, else a GAT_TOK_EXPR token with the code stored for pass #2. 
+   returns 1 if done, 0 on an invalid expression and -1 if code would have 
+   to be stored while store is 0. */
+int gat_expr_operands (gat *ga, int store) {
+    gat_expr_parser p;
+    const char *text;
+    size_t length;
+    unsigned first = 1, t;
+
+    for (t = 1; t <= ga->num_tokens; t++) {
+        if (t < ga->num_tokens && !gat_expr_is_sym (ga, t, ',')) {
+            continue;
+        }
+        if (t - first > 1) {
+            gat_token token;
+
+            if (!gat_expr_compile (ga, first, t, &p)) {
+                return 0;
+            }
+            if (p.num_ops == 1 && p.ops[0].op == GAT_EXPR_CONST) {
+                text = gat_expr_text (ga, first, t, &length);
+                gat_expr_number (text, length, p.ops[0].value, &token);
+            } else if (!store) {
+                return -1;
+            } else {
+                token.string = gat_expr_text (ga, first, t, &token.length);
+                token.type = GAT_TOK_EXPR;
+                token.num_value = gat_expr_store (ga, &p);
+                token.num_width = GAT_NUMW_NONE;
+            }
+            gat_expr_collapse (ga, first, t, &token);
+            t = first + 1;
+        }
+        first = t + 1;
+    }
+    return 1;
+}
+
+/* evaluates the expression of tokens from first to the end of the current 
+   line with the symbols defined so far, for the operand of a directive. the 
+   tokens are replaced by a number token. */
+int gat_expr_value (gat *ga, unsigned first) {
+    gat_expr_parser p;
+    gat_token token;
+    const char *text;
+    size_t length;
+    int32_t value;
+    unsigned last = ga->num_tokens;
+
+    if (!gat_expr_compile (ga, first, last, &p)) {
+        return 0;
+    }
+    text = gat_expr_text (ga, first, last, &length);
+    if (!gat_expr_run (ga, p.ops, NULL, text, length, &value)) {
+        return 0;
+    }
+    gat_expr_number (text, length, value, &token);
+    gat_expr_collapse (ga, first, last, &token);
+    return 1;
+}
+
+/* evaluates the GAT_TOK_EXPR token at index */
+int gat_expr_eval (gat *ga, unsigned index, int32_t *value) {
+    const gat_token *token = &ga->arr_raw_tokens[index];
+    return gat_expr_run (ga, ga->expr_ops + token->num_value, ga->expr_names, 
+                         token->string, token->length, value);
+}
+
+/* tests if the symbols of the GAT_TOK_EXPR token at index are all defined */
+int gat_expr_defined (gat *ga, unsigned index) {
+    const gat_expr_op *op = ga->expr_ops + gat_token_value(ga, index);
+    int32_t value;
+
+    for (; op->op != GAT_EXPR_END; op++) {
+        if (op->op == GAT_EXPR_SYMBOL && !gat_expr_symbol (ga, ga->expr_names + op->name, &value)) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_image.c  memory image the assembly phase writes code into. */
+#include "gat_image.h"
+#include "gat_core.h"
+#include "gat_str.h"
+#include "gat_err.h"
+#include <stdlib.h>
+
+/* readies an empty image for assembly; it is allocated on first use */
+void gat_image_begin (gat *ga) {
+    if (ga->image == NULL) {
+        ga->image = (gat_image *)malloc (sizeof(gat_image));
+        if (ga->image == NULL) {
+            gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+        }
+    }
+    /* bytes and lines are only read where the bitmaps are set */
+    memset (ga->image->coverage, 0, sizeof(ga->image->coverage));
+    memset (ga->image->starts, 0, sizeof(ga->image->starts));
+    ga->image->covered = 0;
+    ga->image->overlapping = 0;
+}
+
+void gat_image_free (gat *ga) {
+    free (ga->image);
+    ga->image = NULL;
+}
+
+/* writes code of an instruction at offset. returns 1 if it overwrote code 
+   written earlier; later code wins. offset + size must be within the image. */
+int gat_image_write (gat_image *image, uint32_t offset, const uint8_t *bytes, unsigned size, 
+                     uint32_t line_num) {
+    int overlap = 0;
+    unsigned i;
+
+    for (i = 0; i < size; i++) {
+        uint32_t addr = offset + i;
+        uint8_t mask = (uint8_t)(1 << (addr & 7));
+        if (image->coverage[addr >> 3] & mask) {
+            overlap = 1;
+        } else {
+            image->coverage[addr >> 3]|= mask;
+            ++image->covered;
+        }
+        image->starts[addr >> 3]&= (uint8_t)~mask;
+        image->bytes[addr] = bytes[i];
+    }
+    if (size > 0) {
+        image->starts[offset >> 3]|= (uint8_t)(1 << (offset & 7));
+        image->lines[offset] = line_num;
+    }
+    return overlap;
+}
+
+/* finds the next run of written addresses at or after *start. returns 0 when 
+   there is none; eight addresses are skipped at once where the bitmap allows. */
+int gat_image_next_run (const gat_image *image, uint32_t *start, uint32_t *length) {
+    uint32_t addr = *start, end;
+
+    while (addr < GAT_IMAGE_SIZE && !gat_image_covered (image, addr)) {
+        addr = ((addr & 7) == 0 && image->coverage[addr >> 3] == 0) ? addr + 8 : addr + 1;
+    }
+    if (addr >= GAT_IMAGE_SIZE) {
+        return 0;
+    }
+    end = addr;
+    while (end < GAT_IMAGE_SIZE && gat_image_covered (image, end)) {
+        end = ((end & 7) == 0 && image->coverage[end >> 3] == 0xFF) ? end + 8 : end + 1;
+    }
+
+    *start = addr;
+    *length = end - addr;
+    return 1;
+}
@@ -0,0 +1,430 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_include.c  INCLUDE. included files are read and tokenized once per 
+    process into a cache keyed by path and modification time, shared by all 
+    assembler contexts; an include scans the cached token lines in place. */
+#include "gat_include.h"
+#include "gat_core.h"
+#include "gat_str.h"
+#include "gat_parser.h"
+#include "gat_tokenizer.h"
+#include "gat_thread.h"
+#include "gat_err.h"
+#include <stdlib.h>
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+/* initial capacities; arrays double from here */
+#define GAT_INCL_INIT_FILES         8
+#define GAT_INCL_INIT_LINES         256
+#define GAT_INCL_INIT_TOKENS        1024
+
+/* cached files; the list and the reference counts are guarded by the lock */
+static gat_incl_file *g_incl_files = NULL;
+static gat_mutex g_incl_mutex = GAT_MUTEX_INIT;
+
+void gat_include_init (gat *ga) {
+    ga->includes = NULL;
+    ga->num_includes = 0;
+    ga->max_includes = 0;
+    ga->file = 0;
+    ga->include_depth = 0;
+}
+
+static void gat_incl_file_free (gat_incl_file *file) {
+    free (file->text);
+    free (file->lines);
+    free (file->tokens);
+    free (file);
+}
+
+/* drops a reference to a cached file; a stale file goes with the last one */
+static void gat_include_release (gat_incl_file *file) {
+    gat_mutex_lock (&g_incl_mutex);
+    if (--file->refs == 0 && file->stale) {
+        gat_incl_file_free (file);
+    }
+    gat_mutex_unlock (&g_incl_mutex);
+}
+
+/* releases the files referenced by the source keeping allocated memory */
+void gat_include_reset (gat *ga) {
+    unsigned i;
+
+    for (i = 0; i < ga->num_includes; i++) {
+        gat_include_release (ga->includes[i]);
+    }
+    ga->num_includes = 0;
+    ga->file = 0;
+    ga->include_depth = 0;
+}
+
+void gat_include_free (gat *ga) {
+    gat_include_reset (ga);
+    free (ga->includes);
+    gat_include_init (ga);
+}
+
+/* frees cached files no context references */
+void gat_include_purge (void) {
+    gat_incl_file **link = &g_incl_files;
+
+    gat_mutex_lock (&g_incl_mutex);
+    while (*link != NULL) {
+        gat_incl_file *file = *link;
+        if (file->refs == 0) {
+            *link = file->next;
+            gat_incl_file_free (file);
+        } else {
+            link = &file->next;
+        }
+    }
+    gat_mutex_unlock (&g_incl_mutex);
+}
+
+/* returns path of a file for diagnostics; 0 is the source */
+const char *gat_file_path (const gat *ga, unsigned file) {
+    if (file > 0) {
+        return ga->includes[file - 1]->path;
+    }
+    return ga->num_ios > 0 ? ga->ios[0].path : "<none>";
+}
+
+/* grows an array to hold count elements; returns 0 if out of memory. the 
+   cache lock may be held, so running out of memory doesn't unwind. */
+static int gat_include_grow (void **arr, size_t elem_size, size_t count, unsigned *capacity, 
+                             unsigned init_capacity) {
+    unsigned new_capacity = *capacity > 0 ? *capacity : init_capacity;
+    void *temp;
+
+    if (count <= *capacity) {
+        return 1;
+    }
+    while (new_capacity < count) {
+        new_capacity*= 2;
+    }
+    temp = realloc (*arr, new_capacity * elem_size);
+    if (temp == NULL) {
+        return 0;
+    }
+    *arr = temp;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/* reads and tokenizes the file at path; returns NULL if it can't be read or 
+   memory runs out */
+static gat_incl_file *gat_include_load (const char *path, uint64_t mtime, uint64_t size) {
+    gat_incl_file *file;
+    unsigned max_lines = 0, max_tokens = 0;
+    const char *pos, *end;
+    FILE *fp;
+
+    file = (gat_incl_file *)calloc (1, sizeof(gat_incl_file));
+    if (file == NULL) {
+        return NULL;
+    }
+    memcpy (file->path, path, strlen (path) + 1);   /* resolved paths fit */
+    file->mtime = mtime;
+    file->size = size;
+
+    /* read the whole file */
+    fp = fopen (path, "rb");
+    file->text = (char *)malloc ((size_t)size + 1);
+    if (fp == NULL || file->text == NULL || fread (file->text, 1, (size_t)size, fp) != size) {
+        if (fp != NULL) {
+            fclose (fp);
+        }
+        gat_incl_file_free (file);
+        return NULL;
+    }
+    fclose (fp);
+
+    /* tokenize lines holding tokens or tokenizer errors */
+    pos = file->text;
+    end = file->text + size;
+    while (pos < end) {
+        const char *view = pos;
+        const char *eol = (const char *)memchr (view, '\n', end - view);
+        gat_token tokens [GAT_MAX_TOKENS];
+        unsigned num_tokens, status;
+        gat_incl_line *line;
+        size_t length;
+
+        if (eol == NULL) {
+            eol = end;
+        }
+        pos = eol + (eol < end ? 1 : 0);
+        ++file->total_lines;
+
+        length = gat_trim_view (&view, eol - view);
+        if (length == 0) {
+            continue;
+        }
+        status = gat_tokenize_text (view, length, tokens, &num_tokens);
+        if (num_tokens == 0 && status == 0) {
+            continue;
+        }
+
+        if ( !gat_include_grow ((void **)&file->lines, sizeof(gat_incl_line), 
+                                file->num_lines + 1, &max_lines, GAT_INCL_INIT_LINES) || 
+             !gat_include_grow ((void **)&file->tokens, sizeof(gat_token), 
+                                file->num_tokens + num_tokens, &max_tokens, 
+                                GAT_INCL_INIT_TOKENS) ) {
+            gat_incl_file_free (file);
+            return NULL;
+        }
+        line = file->lines + file->num_lines++;
+        line->line_num = file->total_lines;
+        line->token_base = file->num_tokens;
+        line->num_tokens = (uint8_t)num_tokens;
+        line->status = (uint8_t)status;
+        memcpy (file->tokens + file->num_tokens, tokens, num_tokens * sizeof(gat_token));
+        file->num_tokens+= num_tokens;
+    }
+
+    return file;
+}
+
+/* returns a reference to the cached file at path, reading it if it isn't 
+   cached or has changed since. hit is set if the file was cached. files are 
+   read under the lock so that jobs including the same file at once read it 
+   only once. returns NULL if the file can't be read. */
+static gat_incl_file *gat_include_acquire (const char *path, uint64_t mtime, uint64_t size, 
+                                           int *hit) {
+    gat_incl_file **link, *file;
+
+    gat_mutex_lock (&g_incl_mutex);
+    for (link = &g_incl_files; *link != NULL; link = &(*link)->next) {
+        file = *link;
+        if (strcmp (file->path, path) != 0) {
+            continue;
+        }
+        if (file->mtime == mtime && file->size == size) {
+            ++file->refs;
+            gat_mutex_unlock (&g_incl_mutex);
+            *hit = 1;
+            return file;
+        }
+
+        /* file changed; sources still using the old text keep it */
+        *link = file->next;
+        if (file->refs == 0) {
+            gat_incl_file_free (file);
+        } else {
+            file->stale = 1;
+        }
+        break;
+    }
+
+    file = gat_include_load (path, mtime, size);
+    if (file != NULL) {
+        file->refs = 1;
+        file->next = g_incl_files;
+        g_incl_files = file;
+    }
+    gat_mutex_unlock (&g_incl_mutex);
+    *hit = 0;
+    return file;
+}
+
+/* gets modification time and size of a regular file; returns 0 if there is 
+   no such file. the time has sub-second resolution so that a file rewritten 
+   within a second isn't taken for the cached one. */
+static int gat_include_stat (const char *path, uint64_t *mtime, uint64_t *size) {
+#ifdef WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if ( !GetFileAttributesExA (path, GetFileExInfoStandard, &data) || 
+         (data.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_DEVICE)) ) {
+        return 0;
+    }
+    /* 100ns units */
+    *mtime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | 
+             data.ftLastWriteTime.dwLowDateTime;
+    *size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+#else
+    struct stat st;
+    if (stat (path, &st) != 0 || !S_ISREG (st.st_mode)) {
+        return 0;
+    }
+    /* ns units */
+#  if defined(__MACH__) || defined(__APPLE__)
+    *mtime = (uint64_t)st.st_mtimespec.tv_sec * 1000000000u + (uint64_t)st.st_mtimespec.tv_nsec;
+#  else
+    *mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000u + (uint64_t)st.st_mtim.tv_nsec;
+#  endif
+    *size = (uint64_t)st.st_size;
+#endif
+    return 1;
+}
+
+/* makes path of an include relative to the directory of the file including 
+   it, or to the include directory for a source set from memory; absolute 
+   paths are taken as they are. returns 0 if the path is too long. */
+static int gat_include_resolve (gat *ga, const gat_token *token, char *path) {
+    const char *base = gat_file_path (ga, ga->file);
+    size_t dir_len = 0, i;
+    int sep = 0;
+
+    if ( token->string[0] != '/' && token->string[0] != '\\' && 
+         !(token->length > 1 && token->string[1] == ':') ) {
+        if (ga->file == 0 && ga->src_borrowed) {
+            base = ga->include_dir;
+            dir_len = strlen (base);
+            sep = dir_len > 0 && base[dir_len - 1] != '/' && base[dir_len - 1] != '\\';
+        } else {
+            for (i = 0; base[i] != '\0'; i++) {
+                if (base[i] == '/' || base[i] == '\\') {
+                    dir_len = i + 1;
+                }
+            }
+        }
+    }
+    if (dir_len + sep + token->length > GAT_MAX_PATH) {
+        return 0;
+    }
+    memcpy (path, base, dir_len);
+    if (sep) {
+        path[dir_len++] = '/';
+    }
+    memcpy (path + dir_len, token->string, token->length);
+    path[dir_len + token->length] = '\0';
+    return 1;
+}
+
+/* returns the file no of a cached file in the files of the source, adding it 
+   if it's new. the source holds one reference per file. */
+static unsigned gat_include_add (gat *ga, gat_incl_file *file) {
+    unsigned i;
+
+    for (i = 0; i < ga->num_includes; i++) {
+        if (ga->includes[i] == file) {
+            gat_include_release (file);
+            return i + 1;
+        }
+    }
+    ga->includes[ga->num_includes++] = file;
+    return ga->num_includes;
+}
+
+/* scans the lines of an included file as lines of the source. diagnostics 
+   name the included file and its line; END ends the source. */
+static void gat_include_scan (gat *ga, const gat_incl_file *file, unsigned file_no, 
+                              int *flag_end) {
+    uint32_t line_num = ga->line_num;
+    uint16_t parent = ga->file;
+    unsigned i;
+
+    ga->include_stack[ga->include_depth++] = (uint16_t)file_no;
+    ga->file = (uint16_t)file_no;
+
+    for (i = 0; i < file->num_lines && !*flag_end && !ga->fatal_error; i++) {
+        const gat_incl_line *line = file->lines + i;
+
+        ga->line_num = line->line_num;
+        ga->num_tokens = line->num_tokens;
+        memcpy (ga->arr_raw_tokens, file->tokens + line->token_base, 
+                line->num_tokens * sizeof(gat_token));
+        gat_tokenize_errors (ga, line->status);
+        gat_prepare_tokens (ga);
+        if (ga->num_tokens > 0) {
+            gat_scan_line (ga, flag_end);
+        }
+    }
+    ga->stats.lines+= *flag_end ? ga->line_num : file->total_lines;
+
+    --ga->include_depth;
+    ga->file = parent;
+    ga->line_num = line_num;
+}
+
+/* parses INCLUDE "path" and scans the file */
+void gat_parse_include (gat *ga, int *flag_end) {
+    const gat_token *token = &ga->arr_raw_tokens[1];
+    char path [GAT_MAX_PATH + 1];
+    uint64_t mtime, size;
+    gat_incl_file *file;
+    size_t capacity;
+    unsigned file_no, d;
+    int hit;
+
+    if (token->type != GAT_TOK_STRING || token->length == 0) {
+        gat_error (ga, GAT_ERR_INVALID_OPERANDS, "quoted path expected : include");
+        return;
+    }
+    if (ga->file == 0 && ga->src_borrowed && ga->include_dir == NULL) {
+        gat_error (ga, GAT_ERR_INCLUDE_FILE, "include without an include directory : %s", 
+                    gat_token_str(ga, 1));
+        return;
+    }
+    if ( !gat_include_resolve (ga, token, path) ) {
+        gat_error (ga, GAT_ERR_INCLUDE_FILE, "include path too long : %s", gat_token_str(ga, 1));
+        return;
+    }
+    if (ga->include_depth > GAT_MAX_INCLUDE_DEPTH) {
+        gat_error (ga, GAT_ERR_INCLUDE_TOO_DEEP, "include nesting too deep : '%s'", path);
+        return;
+    }
+    if (ga->num_includes == 0xFFFF) {
+        gat_error (ga, GAT_ERR_INCLUDE_FILE, "too many include files : '%s'", path);
+        return;
+    }
+
+    /* the source including itself is file 0, which is always on the stack */
+    if ( !ga->src_borrowed && strcmp (path, gat_file_path (ga, 0)) == 0 ) {
+        file = NULL;
+        file_no = 0;
+        hit = 0;
+    } else {
+        if ( !gat_include_stat (path, &mtime, &size) ) {
+            gat_error (ga, GAT_ERR_INCLUDE_FILE, "error opening include file : '%s'", path);
+            return;
+        }
+
+        /* make room first; running out of memory unwinds */
+        capacity = ga->max_includes;
+        ga->includes = (gat_incl_file **)gat_grow (ga, ga->includes, sizeof(gat_incl_file *), 
+                                                   ga->num_includes + 1, &capacity, 
+                                                   GAT_INCL_INIT_FILES);
+        ga->max_includes = (unsigned)capacity;
+
+        file = gat_include_acquire (path, mtime, size, &hit);
+        if (file == NULL) {
+            gat_error (ga, GAT_ERR_INCLUDE_FILE, "error reading include file : '%s'", path);
+            return;
+        }
+        file_no = gat_include_add (ga, file);
+    }
+
+    for (d = 0; d < ga->include_depth; d++) {
+        if (ga->include_stack[d] == file_no) {
+            gat_error (ga, GAT_ERR_INCLUDE_FILE, "recursive include : '%s'", path);
+            return;
+        }
+    }
+
+    ++ga->stats.includes;
+    ga->stats.include_hits+= hit;
+    gat_include_scan (ga, file, file_no, flag_end);
+}
@@ -20,11 +20,197 @@
 #include "gat_core.h"
 #include "gat_str.h"
 #include "gat_err.h"
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h> /* _get_osfhandle() */
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#if defined(__MACH__) || defined(__APPLE__)
+#include <stdlib.h>
+#else
+#include <malloc.h>
+#endif
+
+/* size of the first chunk when source has to be read instead of mapped */
+#define GAT_SOURCE_READ_CHUNK       (64 * 1024)
+
+/* maps the whole input file in memory; returns 0 if file can't be mapped 
+   like pipes, devices and empty files */
+static int gat_map_source (gat *ga, FILE *fp) {
+#ifdef WIN32
+    HANDLE hfile, hmap;
+    LARGE_INTEGER size;
+    const char *view;
+
+    hfile = (HANDLE)_get_osfhandle (_fileno (fp));
+    if (hfile == INVALID_HANDLE_VALUE || GetFileType (hfile) != FILE_TYPE_DISK) {
+        return 0;
+    }
+    if (!GetFileSizeEx (hfile, &size) || size.QuadPart == 0 || size.HighPart != 0) {
+        return 0;
+    }
+    hmap = CreateFileMapping (hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hmap == NULL) {
+        return 0;
+    }
+    view = (const char *)MapViewOfFile (hmap, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle (hmap); /* view keeps the mapping alive */
+    if (view == NULL) {
+        return 0;
+    }
+    ga->src = view;
+    ga->src_size = (size_t)size.LowPart;
+#else
+    struct stat st;
+    void *view;
+
+    if (fstat (fileno (fp), &st) != 0 || !S_ISREG (st.st_mode) || st.st_size == 0) {
+        return 0;
+    }
+    view = mmap (NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+    if (view == MAP_FAILED) {
+        return 0;
+    }
+#  ifdef MADV_SEQUENTIAL
+    madvise (view, (size_t)st.st_size, MADV_SEQUENTIAL);
+#  endif
+    ga->src = (const char *)view;
+    ga->src_size = (size_t)st.st_size;
+#endif
+    ga->src_mapped = 1;
+    return 1;
+}
+
+/* reads the whole input in one growing buffer; used when input can't be mapped. 
+   returns 1 if read, 0 on a read error and -1 when out of memory. */
+static int gat_read_source (gat *ga, FILE *fp) {
+    size_t size_buff = GAT_SOURCE_READ_CHUNK;
+    size_t size = 0;
+    char *buff = (char *)malloc (size_buff);
+
+    while (buff != NULL) {
+        size_t count = fread (buff + size, 1, size_buff - size, fp);
+        size+= count;
+        if (size < size_buff) {
+            if (ferror (fp)) {
+                free (buff);
+                return 0;
+            }
+            break; /* end of input */
+        }
+        /* buffer is full; double it */
+        {
+            char *temp = (char *)realloc (buff, size_buff * 2);
+            if (temp == NULL) {
+                free (buff);
+                buff = NULL;
+                break;
+            }
+            buff = temp;
+            size_buff*= 2;
+        }
+    }
+
+    if (buff == NULL) {
+        return -1;
+    }
+
+    ga->src = buff;
+    ga->src_size = size;
+    ga->src_mapped = 0;
+    return 1;
+}
+
+/* loads source text from input file; maps it when possible or reads it in full */
+void gat_load_source (gat *ga) {
+    FILE *fp = ga->ios[0].fp;
+    int status;
+
+    ga->src = NULL;
+    ga->src_size = 0;
+    ga->src_pos = 0;
+    ga->src_mapped = 0;
+
+    status = gat_map_source (ga, fp) ? 1 : gat_read_source (ga, fp);
+    if (status == -1) {
+        gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory reading input file: '%s'", 
+                            ga->ios[0].path);
+    } else if (status == 0) {
+        gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "error reading input file: '%s'", 
+                            ga->ios[0].path);
+    }
+}
+
+/* opens the input file and loads source text ahead of the engine run, so that 
+   it can be looked at without reading the file twice. returns 0 if it can't 
+   be loaded; the engine then opens the file again and reports the error. */
+int gat_preload_source (gat *ga) {
+    gat_io *io = ga->ios;
+
+    if (ga->src != NULL) {
+        return 1;
+    }
+    io->fp = fopen (io->path, io->mode);
+    if (io->fp == NULL) {
+        return 0;
+    }
+    ga->src_pos = 0;
+    ga->src_mapped = 0;
+    if (gat_map_source (ga, io->fp) || gat_read_source (ga, io->fp) == 1) {
+        return 1;
+    }
+    fclose (io->fp);
+    io->fp = NULL;
+    return 0;
+}
+
+/* releases source text; borrowed text belongs to the caller */
+void gat_unload_source (gat *ga) {
+    if (ga->src != NULL && !ga->src_borrowed) {
+        if (ga->src_mapped) {
+#ifdef WIN32
+            UnmapViewOfFile (ga->src);
+#else
+            munmap ((void *)ga->src, ga->src_size);
+#endif
+        } else {
+            free ((void *)ga->src);
+        }
+    }
+    ga->src = NULL;
+    ga->src_size = 0;
+    ga->src_pos = 0;
+    ga->src_mapped = 0;
+    ga->src_borrowed = 0;
+}
+
+/* sets source text from memory in place of an input file. the text is read in 
+   place and must outlive the engine run; path names the source in messages. */
+void gat_set_source (gat *ga, const char *path, const char *text, size_t size) {
+    gat_attach_io (ga, "", path, NULL);
+    ga->src = text;
+    ga->src_size = size;
+    ga->src_pos = 0;
+    ga->src_mapped = 0;
+    ga->src_borrowed = 1;
+}
+
+/* resets the read position to the beginning of source text */
+void gat_rewind_source (gat *ga) {
+    ga->src_pos = 0;
+}
 
 void gat_open_files (gat *ga) {
     unsigned i;
     for (i = 0; i < ga->num_ios; i++) {     
         gat_io *io = ga->ios + i;
+        if (i == 0 && ga->src != NULL) {
+            continue; /* source text is in memory; borrowed or preloaded */
+        }
         if (i > 0) {
             gat_kill_file (ga, io->path);
         }
@@ -35,11 +221,15 @@ void gat_open_files (gat *ga) {
                 i == 0 ? "input" : "output", 
                 io->path);
         }
+        if (i == 0) {
+            gat_load_source (ga);
+        }
     }
 }
 
 void gat_close_files (gat *ga) {
     unsigned i;
+    gat_unload_source (ga);
     for (i = 0; i < ga->num_ios; i++) {     
         gat_io *io = ga->ios + i;
         if (io->fp) {
@@ -49,33 +239,32 @@ void gat_close_files (gat *ga) {
     }
 }
 
+/* reads the next non-blank line from source text. the line is returned as a 
+   trimmed view into source text in ga->line and ga->line_len. */
 int gat_read_line (gat *ga) {
-    FILE *fpin = ga->ios[0].fp;
-    int flag_done;
-    
-    /* clear buffer */
-    ga->str_line[0] = '\0';
-    flag_done = 0;
+    const char *end = ga->src + ga->src_size;
     
-    while (!feof(fpin) && !flag_done) {
-        /* temp line buffer */
-        char buff [GAT_MAX_LINEBUFF_SIZE + 1];
-        buff[0] = '\0';
+    ga->line = NULL;
+    ga->line_len = 0;
 
-        /* read line */
-        fgets (buff, GAT_MAX_LINEBUFF_SIZE, fpin);
+    while (ga->src_pos < ga->src_size) {
+        const char *head = ga->src + ga->src_pos;
+        const char *tail = (const char *)memchr (head, '\n', end - head);
+        if (tail == NULL) {
+            tail = end;
+        }
+        ga->src_pos = (tail - ga->src) + (tail < end ? 1 : 0);
         ++ga->line_num;
+        ++ga->stats.lines;
         
         /* trim */
-        gat_trim (buff, ga->str_line);
-        if (ga->str_line[0] != '\0') {
-            flag_done = 1;
+        ga->line_len = gat_trim_view (&head, tail - head);
+        if (ga->line_len > 0) {
+            ga->line = head;
+            return 1;
         }
     }
 
-    if (strlen(ga->str_line) > 0) {
-        return 1;
-    }
     return 0;
 }
 
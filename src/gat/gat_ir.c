@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_ir.c  line IR retained by the analysis phase for the assembly phase. */
+#include "gat_ir.h"
+#include "gat_core.h"
+#include "gat_str.h"
+#include "gat_err.h"
+#if defined(__MACH__) || defined(__APPLE__)
+#include <stdlib.h>
+#else
+#include <malloc.h>
+#endif
+
+/* initial capacities; arrays double from here */
+#define GAT_IR_INIT_LINES           1024
+#define GAT_IR_INIT_TOKENS          4096
+#define GAT_IR_INIT_FIXUPS          256
+
+void gat_ir_init (gat_ir *ir) {
+    memset (ir, 0, sizeof(gat_ir));
+}
+
+/* empties the IR keeping allocated memory for reuse */
+void gat_ir_reset (gat_ir *ir) {
+    ir->num_lines = 0;
+    ir->num_tokens = 0;
+    ir->num_fixups = 0;
+}
+
+void gat_ir_free (gat_ir *ir) {
+    free (ir->lines);
+    free (ir->tokens);
+    free (ir->fixups);
+    gat_ir_init (ir);
+}
+
+/* records current line and its tokens into the IR */
+void gat_ir_add_line (gat *ga, uint8_t kind, int instr) {
+    gat_ir *ir = &ga->ir;
+    gat_line *line;
+    size_t capacity;
+    unsigned i;
+
+    capacity = ir->max_lines;
+    ir->lines = (gat_line *)gat_grow (ga, ir->lines, sizeof(gat_line), 
+                                      ir->num_lines + 1, &capacity, GAT_IR_INIT_LINES);
+    ir->max_lines = (unsigned)capacity;
+
+    capacity = ir->max_tokens;
+    ir->tokens = (gat_ir_token *)gat_grow (ga, ir->tokens, sizeof(gat_ir_token), 
+                                           ir->num_tokens + ga->num_tokens, &capacity, 
+                                           GAT_IR_INIT_TOKENS);
+    ir->max_tokens = (unsigned)capacity;
+
+    line = ir->lines + ir->num_lines++;
+    line->line_num = ga->line_num;
+    line->offset = ga->offset;
+    line->instr = instr;
+    line->kind = kind;
+    line->num_tokens = (uint8_t)ga->num_tokens;
+    line->file = ga->file;
+    line->token_base = ir->num_tokens;
+    line->bin_size = 0;
+
+    /* token slices stay valid as source text lives through both passes */
+    for (i = 0; i < ga->num_tokens; i++) {
+        gat_ir_token *token = ir->tokens + ir->num_tokens++;
+        token->token = ga->arr_raw_tokens[i];
+        token->opclass = ga->arr_token_class[i];
+        token->value = ga->arr_cooked_tokens[i];
+    }
+}
+
+/* grows the IR to hold num_lines lines and num_tokens tokens */
+void gat_ir_reserve (gat *ga, unsigned num_lines, unsigned num_tokens) {
+    gat_ir *ir = &ga->ir;
+    size_t capacity;
+
+    capacity = ir->max_lines;
+    ir->lines = (gat_line *)gat_grow (ga, ir->lines, sizeof(gat_line), 
+                                      num_lines, &capacity, GAT_IR_INIT_LINES);
+    ir->max_lines = (unsigned)capacity;
+
+    capacity = ir->max_tokens;
+    ir->tokens = (gat_ir_token *)gat_grow (ga, ir->tokens, sizeof(gat_ir_token), 
+                                           num_tokens, &capacity, GAT_IR_INIT_TOKENS);
+    ir->max_tokens = (unsigned)capacity;
+}
+
+/* loads line and its tokens from the IR as the current line */
+void gat_ir_load_line (gat *ga, const gat_line *line) {
+    gat_ir_load_from (ga, &ga->ir, line);
+}
+
+/* loads line of another IR as the current line */
+void gat_ir_load_from (gat *ga, const gat_ir *ir, const gat_line *line) {
+    const gat_ir_token *tokens = ir->tokens + line->token_base;
+    unsigned i;
+
+    ga->line_num = line->line_num;
+    ga->file = line->file;
+    ga->num_tokens = line->num_tokens;
+
+    for (i = 0; i < line->num_tokens; i++) {
+        ga->arr_raw_tokens[i] = tokens[i].token;
+        ga->arr_tokens[i] = NULL;
+        ga->arr_token_class[i] = tokens[i].opclass;
+        ga->arr_cooked_tokens[i] = tokens[i].value;
+    }
+}
+
+/* records the last line added as a fixup; its code is generated once the 
+   symbols it references are defined */
+void gat_ir_add_fixup (gat *ga) {
+    gat_ir *ir = &ga->ir;
+    size_t capacity = ir->max_fixups;
+
+    ir->fixups = (unsigned *)gat_grow (ga, ir->fixups, sizeof(unsigned), 
+                                       ir->num_fixups + 1, &capacity, GAT_IR_INIT_FIXUPS);
+    ir->max_fixups = (unsigned)capacity;
+    ir->fixups[ir->num_fixups++] = ir->num_lines - 1;
+}
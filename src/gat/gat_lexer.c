@@ -24,55 +24,14 @@
 #include "gat_conv.h"
 #include "gat_core.h"
 #include "gat_tokenizer.h"
+#include "gat_ctype.h"
 #include <ctype.h>
 #include <malloc.h>
 
 /* checks if token is a number */
 int gat_is_num (const char *strtext) {
-    const size_t token_length = strlen(strtext);
-    if ( token_length >= 1 && token_length <= GAT_MAX_NUMERIC_TOKEN_LENGTH ) {
-        size_t i, j, k;
-        int bhex;
-        uint8_t ch;
-
-        /* check for nubmer system */
-        if ( strtext[0] == '0' && tolower(strtext[1]) == 'x' ) {
-            i = 2; 
-            j = token_length - 1;
-            bhex = 1;
-        } else if ( tolower (strtext[token_length - 1]) == 'h' ) {
-            i = 0;
-            j = token_length - 2;
-            bhex = 1;
-        } else {
-            i = 0;
-            j = token_length - 1;
-            bhex = 0;
-        }
-
-        /* do the conversion now */
-        if (bhex == 1) {
-            if ( tolower(strtext[token_length - 1])  == 'h' ) {
-                ch = tolower (strtext [i++] ); 
-                if (ch >= 'a' && ch <= 'f') {
-                    return 0; /* NAN */
-                }
-            }
-            for ( k = i; k <= j; k++ ) {
-                if ( !isxdigit ( strtext [k] ) ) {
-                    return 0; /* NAN */
-                }
-            }
-        } else {
-            for ( k = i; k <= j; k++ ) {
-                if ( !isdigit ( strtext [k] ) ) {
-                    return 0; /* NAN */
-                }
-            }
-        }
-        return 1; /* its a number */
-    }
-    return 0; /* NAN */
+    uint32_t value;
+    return gat_decode_num (strtext, strlen(strtext), &value);
 }
 
 /* checks if token is an id */
@@ -82,11 +41,11 @@ int gat_is_id ( const char *strtext ) {
         unsigned i;
         /* id can contain only characters [_a-zA-Z0-9] */
         for ( i = 0; i < token_length; i++ ) {
-            if ( !gat_rngcmp ( strtext[i], "__azAZ09" ) )
+            if ( !gat_ctype_is ( strtext[i], GAT_CC_ID ) )
                 return 0; /* not an id */
         }
         /* id can't start with a numeric digit */
-        if ( isdigit ( strtext [0] ) ) {
+        if ( gat_ctype_is ( strtext [0], GAT_CC_DIGIT ) ) {
             return 0; /* not an id */
         }
         /* id can't have more than 2 continuous _ symbol */
@@ -122,22 +81,12 @@ int gat_is_label (const char *strtext ) {
 
 /* checks if token is a byte value (0xFF) */
 int gat_is_byte ( const char * strtext ) {
-    if ( gat_is_num (strtext) ) {
-        uint32_t value = gat_cnum ( strtext );
-        if ( value <= GAT_MAX_BYTE ) {
-            return 1; /* its a byte value */
-        }
-    }
-    return 0; /* not a byte value */
+    uint32_t value;
+    return gat_decode_num (strtext, strlen(strtext), &value) && value <= GAT_MAX_BYTE;
 }
 
 /* checks if token is a double byte value (0xFFFF) */
 int gat_is_dbl ( const char *strtext ) {
-    if ( gat_is_num (strtext) ) {
-          uint32_t value = gat_cnum ( strtext );
-          if ( value <= GAT_MAX_DBL ) {
-            return 1; /* its a dbl byte value */
-          }
-    }
-    return 0; /* not a dbl value */
+    uint32_t value;
+    return gat_decode_num (strtext, strlen(strtext), &value) && value <= GAT_MAX_DBL;
 }
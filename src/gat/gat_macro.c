@@ -0,0 +1,296 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_macro.c  MACRO / ENDM. macro bodies are kept as the token lines read 
+    when the macro is defined, with parameter tokens resolved to their index; 
+    an expansion substitutes its arguments into them and scans the lines 
+    without reading or tokenizing them again. */
+#include "gat_macro.h"
+#include "gat_core.h"
+#include "gat_parser.h"
+#include "gat_table.h"
+#include "gat_lexer.h"
+#include "gat_tokenizer.h"
+#include "gat_err.h"
+#include <stdlib.h>
+
+/* initial capacities; arrays double from here */
+#define GAT_MACRO_INIT_MACROS       16
+#define GAT_MACRO_INIT_LINES        256
+#define GAT_MACRO_INIT_TOKENS       1024
+
+void gat_macro_init (gat *ga) {
+    ga->arr_macros = NULL;
+    ga->num_macros = 0;
+    ga->max_macros = 0;
+    ga->macro_lines = NULL;
+    ga->num_macro_lines = 0;
+    ga->max_macro_lines = 0;
+    ga->macro_tokens = NULL;
+    ga->num_macro_tokens = 0;
+    ga->max_macro_tokens = 0;
+    ga->macro_def = -1;
+    ga->macro_depth = 0;
+}
+
+/* removes all macros keeping allocated memory */
+void gat_macro_reset (gat *ga) {
+    ga->num_macros = 0;
+    ga->num_macro_lines = 0;
+    ga->num_macro_tokens = 0;
+    ga->macro_def = -1;
+    ga->macro_depth = 0;
+}
+
+void gat_macro_free (gat *ga) {
+    free (ga->arr_macros);
+    free (ga->macro_lines);
+    free (ga->macro_tokens);
+    gat_macro_init (ga);
+}
+
+/* tests if token at index is a ',' */
+static int gat_is_comma (gat *ga, unsigned index) {
+    const gat_token *token = &ga->arr_raw_tokens[index];
+    return token->type == GAT_TOK_SYMBOL && token->length == 1 && token->string[0] == ',';
+}
+
+/* appends token to macro tokens; a token naming a parameter of macro is 
+   marked with its index */
+static void gat_macro_add_token (gat *ga, const gat_macro *macro, const gat_token *token) {
+    gat_macro_token *mtoken;
+    size_t capacity = ga->max_macro_tokens;
+    unsigned p;
+
+    ga->macro_tokens = (gat_macro_token *)gat_grow (ga, ga->macro_tokens, sizeof(gat_macro_token), 
+                                                    ga->num_macro_tokens + 1, &capacity, 
+                                                    GAT_MACRO_INIT_TOKENS);
+    ga->max_macro_tokens = (unsigned)capacity;
+
+    mtoken = ga->macro_tokens + ga->num_macro_tokens++;
+    mtoken->token = *token;
+    mtoken->param = -1;
+    for (p = 0; p < macro->num_params; p++) {
+        const gat_token *param = &ga->macro_tokens[macro->param_base + p].token;
+        if (param->length == token->length && 
+            memcmp (param->string, token->string, token->length) == 0) {
+            mtoken->param = (int8_t)p;
+            break;
+        }
+    }
+}
+
+/* parses a macro definition -> id MACRO [id {, id}] and starts recording 
+   its body. the body is recorded even if the definition is invalid so that 
+   its lines are not scanned. */
+void gat_parse_macro (gat *ga) {
+    const char *name = gat_token_str(ga, 0);
+    gat_macro *macro;
+    size_t capacity;
+    unsigned t;
+    int valid = 1;
+
+    /* the lines of an expansion are not read from the source */
+    if (ga->macro_depth > 0) {
+        gat_error (ga, GAT_ERR_MACRO_NESTING, "macro defined by a macro expansion : %s", name);
+        return;
+    }
+
+    if ( !gat_is_id (name) ) {
+        gat_error (ga, GAT_ERR_INVALID_ID, "invalid macro-identifier : %s", name);
+        valid = 0;
+    } else if ( gat_is_reg (ga, name) ) {
+        gat_error (ga, GAT_ERR_RESERVED_NAME, "use of register name as macro-identifier : %s", 
+                    name);
+        valid = 0;
+    } else if ( gat_search_instr (ga, ga->arr_raw_tokens[0].string, 
+                                  ga->arr_raw_tokens[0].length) != -1 ) {
+        gat_error (ga, GAT_ERR_RESERVED_NAME, "use of instruction name as macro-identifier : %s", 
+                    name);
+        valid = 0;
+    }
+
+    capacity = ga->max_macros;
+    ga->arr_macros = (gat_macro *)gat_grow (ga, ga->arr_macros, sizeof(gat_macro), 
+                                            ga->num_macros + 1, &capacity, GAT_MACRO_INIT_MACROS);
+    ga->max_macros = (unsigned)capacity;
+
+    macro = ga->arr_macros + ga->num_macros;
+    macro->num_params = 0;
+    macro->first_line = ga->num_macro_lines;
+    macro->num_lines = 0;
+    macro->param_base = ga->num_macro_tokens;
+    macro->line_num = ga->line_num;
+    macro->file = ga->file;
+
+    /* parameters; id {, id} */
+    for (t = 2; t < ga->num_tokens; t+= 2) {
+        const gat_token *param = &ga->arr_raw_tokens[t];
+        const char *strparam = gat_token_str(ga, t);
+
+        if ( !gat_is_id (strparam) || gat_is_reg (ga, strparam) || 
+             (t + 1 < ga->num_tokens && !gat_is_comma (ga, t + 1)) || 
+             t + 2 == ga->num_tokens ) {
+            gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid macro parameter : %s", strparam);
+            valid = 0;
+            break;
+        }
+        gat_macro_add_token (ga, macro, param);
+        if (ga->macro_tokens[ga->num_macro_tokens - 1].param != -1) {
+            gat_error (ga, GAT_ERR_REDEFINED, "redefinition of macro parameter : %s", strparam);
+            valid = 0;
+            break;
+        }
+        ++macro->num_params;
+    }
+    if (valid) {
+        gat_define_macro (ga, name, ga->num_macros);
+    }
+    ga->macro_def = (int)ga->num_macros++;
+}
+
+/* records the current line into the body of the macro being defined; ENDM 
+   ends the body. returns 0 if no macro is being defined. */
+int gat_record_macro (gat *ga) {
+    int found[GAT_MAX_TOKENS];
+    gat_macro *macro;
+    gat_macro_line *line;
+    size_t capacity;
+    unsigned num_found, k, t;
+
+    if (ga->macro_def == -1) {
+        return 0;
+    }
+
+    num_found = gat_find_directives (ga, found);
+    for (k = 0; k < num_found; k++) {
+        switch (ga->dirt_table[found[k]].token) {
+        case GAT_ENDM:
+            if (ga->num_tokens != 1) {
+                gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid number of operands : endm");
+            }
+            ga->macro_def = -1;
+            return 1;
+        case GAT_MACRO:
+            gat_error (ga, GAT_ERR_MACRO_NESTING, "nested macro definition : %s", 
+                        gat_token_str(ga, 0));
+            return 1;
+        default:
+            break;
+        }
+    }
+
+    capacity = ga->max_macro_lines;
+    ga->macro_lines = (gat_macro_line *)gat_grow (ga, ga->macro_lines, sizeof(gat_macro_line), 
+                                                  ga->num_macro_lines + 1, &capacity, 
+                                                  GAT_MACRO_INIT_LINES);
+    ga->max_macro_lines = (unsigned)capacity;
+
+    line = ga->macro_lines + ga->num_macro_lines++;
+    line->token_base = ga->num_macro_tokens;
+    line->num_tokens = (uint8_t)ga->num_tokens;
+
+    macro = ga->arr_macros + ga->macro_def;
+    for (t = 0; t < ga->num_tokens; t++) {
+        gat_macro_add_token (ga, macro, &ga->arr_raw_tokens[t]);
+    }
+    ++macro->num_lines;
+    return 1;
+}
+
+/* expands the macro at index invoked by the current line -> id [arg {, arg}]. 
+   an argument is the run of tokens up to the next ','. errors of the body 
+   lines are reported on the line of the invocation. */
+void gat_expand_macro (gat *ga, int index, int *flag_end) {
+    gat_token call [GAT_MAX_TOKENS];
+    uint8_t arg_first [GAT_MAX_TOKENS];
+    uint8_t arg_count [GAT_MAX_TOKENS];
+    unsigned num_call = ga->num_tokens;
+    unsigned num_args = 0;
+    unsigned i, t, k, n;
+
+    /* arguments; comma separated runs of tokens, none empty */
+    for (t = 1; t < num_call; t++) {
+        const unsigned first = t;
+
+        while (t < num_call && !gat_is_comma (ga, t)) {
+            t++;
+        }
+        if (t == first || t + 1 == num_call) {
+            gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid macro arguments : %s", 
+                        gat_token_str(ga, 0));
+            return;
+        }
+        arg_first[num_args] = (uint8_t)first;
+        arg_count[num_args] = (uint8_t)(t - first);
+        ++num_args;
+    }
+    if (num_args != ga->arr_macros[index].num_params) {
+        gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid number of macro arguments : %s", 
+                    gat_token_str(ga, 0));
+        return;
+    }
+    if (ga->macro_depth == GAT_MAX_MACRO_DEPTH) {
+        gat_error (ga, GAT_ERR_MACRO_TOO_DEEP, "macro expansion too deep : %s", 
+                    gat_token_str(ga, 0));
+        return;
+    }
+    /* the body lines overwrite the tokens of the invocation */
+    memcpy (call, ga->arr_raw_tokens, num_call * sizeof(gat_token));
+
+    ++ga->macro_depth;
+    ++ga->stats.macro_expansions;
+    for (i = 0; i < ga->arr_macros[index].num_lines && !*flag_end; i++) {
+        const gat_macro_line *line = ga->macro_lines + ga->arr_macros[index].first_line + i;
+        const gat_macro_token *tokens = ga->macro_tokens + line->token_base;
+
+        /* substitute arguments into the body tokens */
+        for (n = 0, t = 0; t < line->num_tokens; t++) {
+            n+= tokens[t].param == -1 ? 1 : arg_count[tokens[t].param];
+        }
+        if (n > GAT_MAX_TOKENS) {
+            gat_error (ga, GAT_ERR_TOO_MANY_TOKENS, "too many tokens");
+            continue;
+        }
+        ga->num_tokens = n;
+        for (n = 0, t = 0; t < line->num_tokens; t++) {
+            if (tokens[t].param == -1) {
+                ga->arr_raw_tokens[n++] = tokens[t].token;
+            } else {
+                for (k = 0; k < arg_count[tokens[t].param]; k++) {
+                    ga->arr_raw_tokens[n++] = call[arg_first[tokens[t].param] + k];
+                }
+            }
+        }
+        gat_prepare_tokens (ga);
+        ++ga->stats.macro_lines;
+
+        gat_scan_line (ga, flag_end);
+    }
+    --ga->macro_depth;
+}
+
+/* reports a macro definition left without ENDM at the end of the source */
+void gat_end_macros (gat *ga) {
+    if (ga->macro_def != -1) {
+        ga->line_num = ga->arr_macros[ga->macro_def].line_num;
+        ga->file = ga->arr_macros[ga->macro_def].file;
+        gat_error (ga, GAT_ERR_MACRO_NESTING, "macro without endm");
+        ga->macro_def = -1;
+    }
+}
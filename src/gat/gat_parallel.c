@@ -0,0 +1,669 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_parallel.c  parallel engine stages. the source or its IR lines are 
+    split in chunks, one per worker thread. each worker runs on a private copy 
+    of the assembler state sharing the tables and IR of the source, and records 
+    the diagnostics it raises; they are reported in line order once the workers 
+    are done. */
+#include "gat_parallel.h"
+#include "gat_core.h"
+#include "gat_str.h"
+#include "gat_err.h"
+#include "gat_ir.h"
+#include "gat_parser.h"
+#include "gat_expr.h"
+#include "gat_table.h"
+#include "gat_tokenizer.h"
+#include "gat_thread.h"
+#include <stdlib.h>
+
+/* initial capacities; arrays double from here */
+#define GAT_PAR_INIT_DIAGS          64
+#define GAT_PAR_INIT_TEXT           4096
+#define GAT_PAR_INIT_EVENTS         256
+
+/* where a chunk of parallel pass #1 goes in the IR of the source; set by 
+   the ordered merge */
+typedef struct _gat_par_chunk {
+    gat_par_worker *worker;
+    gat_ir *ir;                 /* IR of the source */
+    unsigned limit;             /* chunk lines before END */
+    unsigned line_base;         /* first IR line and token of the chunk */
+    unsigned token_base;
+    uint32_t line_num;          /* source lines before the chunk */
+    uint32_t offset;            /* code offset at chunk start */
+}gat_par_chunk;
+
+/* grows an array to hold count elements; returns 0 if out of memory */
+static int gat_par_grow (void **arr, size_t elem_size, size_t count, size_t *capacity, 
+                         size_t init_capacity) {
+    size_t new_capacity = *capacity > 0 ? *capacity : init_capacity;
+    void *temp;
+
+    if (count <= *capacity) {
+        return 1;
+    }
+    while (new_capacity < count) {
+        new_capacity*= 2;
+    }
+    temp = realloc (*arr, new_capacity * elem_size);
+    if (temp == NULL) {
+        return 0;
+    }
+    *arr = temp;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/* records a diagnostic raised on a worker; the worker is the context */
+static void gat_par_collect (gat *ctx, gat_callback_type type, void *data, void *context) {
+    gat_par_worker *worker = (gat_par_worker *)context;
+    const gat_error_info *err = (const gat_error_info *)data;
+    size_t length, capacity;
+    gat_par_diag *diag;
+
+    if (type != GAT_CALLBACK_ERROR || worker->failed) {
+        return;
+    }
+
+    length = strlen (err->desc) + 1;
+    capacity = worker->max_diags;
+    if ( !gat_par_grow ((void **)&worker->diags, sizeof(gat_par_diag), 
+                        worker->num_diags + 1, &capacity, GAT_PAR_INIT_DIAGS) || 
+         !gat_par_grow ((void **)&worker->text, 1, worker->text_size + length, 
+                        &worker->max_text_size, GAT_PAR_INIT_TEXT) ) {
+        worker->failed = 1;
+        return;
+    }
+    worker->max_diags = (unsigned)capacity;
+
+    diag = worker->diags + worker->num_diags++;
+    diag->index = worker->current;
+    diag->line_num = (uint32_t)err->line;
+    diag->err_no = err->errno;
+    diag->warning = err->warning;
+    diag->text = worker->text_size;
+    memcpy (worker->text + worker->text_size, err->desc, length);
+    worker->text_size+= length;
+}
+
+/* allocates workers and their private assembler state once per context */
+static int gat_par_alloc (gat *ga, unsigned num_workers) {
+    unsigned i;
+
+    if (ga->num_workers >= num_workers) {
+        return 1;
+    }
+    gat_par_free (ga);
+
+    ga->workers = (gat_par_worker *)calloc (num_workers, sizeof(gat_par_worker));
+    if (ga->workers == NULL) {
+        return 0;
+    }
+    ga->num_workers = num_workers;
+    for (i = 0; i < num_workers; i++) {
+        ga->workers[i].ctx = (gat *)malloc (sizeof(gat));
+        if (ga->workers[i].ctx == NULL) {
+            gat_par_free (ga);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* prepares a worker to handle IR lines [first, last) */
+static void gat_par_begin (gat *ga, gat_par_worker *worker, unsigned first, unsigned last) {
+    gat *ctx = worker->ctx;
+
+    /* tables, symbols and IR are shared read only; everything a line 
+       writes is private to the worker */
+    memcpy (ctx, ga, sizeof(gat));
+    ctx->callback = gat_par_collect;
+    ctx->context = worker;
+    ctx->fatal_jmp_armed = 0;
+    ctx->max_errors = 0;
+    ctx->err_count = 0;
+    ctx->warn_count = 0;
+    memset (&ctx->stats, 0, sizeof(gat_stats));
+
+    worker->first = first;
+    worker->last = last;
+    worker->current = first;
+    worker->num_diags = 0;
+    worker->text_size = 0;
+    worker->failed = 0;
+}
+
+/* adds counters of the worker to the source */
+static void gat_par_end (gat *ga, gat_par_worker *worker) {
+    ga->stats.sym_lookups+= worker->ctx->stats.sym_lookups;
+    ga->stats.sym_probes+= worker->ctx->stats.sym_probes;
+    ga->stats.kw_lookups+= worker->ctx->stats.kw_lookups;
+}
+
+/* encodes instructions of the worker's lines into the IR lines */
+static void gat_par_encode_lines (void *arg) {
+    gat_par_worker *worker = (gat_par_worker *)arg;
+    gat *ctx = worker->ctx;
+    unsigned i;
+
+    for (i = worker->first; i < worker->last; i++) {
+        gat_line *line = ctx->ir.lines + i;
+
+        if (line->kind == GAT_LINE_ORG) {
+            continue;
+        }
+        worker->current = i;
+        gat_ir_load_line (ctx, line);
+        if (gat_gen_instruction (ctx, &ctx->instr_table[line->instr])) {
+            memcpy (line->bin, ctx->bin, ctx->bin_size);
+            line->bin_size = (uint8_t)ctx->bin_size;
+        } else {
+            line->bin_size = 0;
+        }
+    }
+}
+
+/* runs count jobs of args on threads; the calling thread runs the first job 
+   and any job a thread could not be started for */
+static void gat_par_run (void (*run)(void *), void *args, size_t arg_size, unsigned count) {
+    gat_thread threads [GAT_PAR_MAX_THREADS];
+    unsigned num_started, i;
+
+    for (num_started = 1; num_started < count; num_started++) {
+        if ( !gat_thread_start (threads + num_started, run, 
+                                (char *)args + num_started * arg_size) ) {
+            break;
+        }
+    }
+    run (args);
+    for (i = num_started; i < count; i++) {
+        run ((char *)args + i * arg_size);
+    }
+    for (i = 1; i < num_started; i++) {
+        gat_thread_join (threads + i);
+    }
+}
+
+/* encodes instructions of the IR on worker threads into the bin of their 
+   lines. writing the code into the image is left to the caller, which walks 
+   the lines in order and reports the diagnostics with gat_par_report. returns 
+   0 if the lines are to be assembled serially instead. */
+int gat_par_encode (gat *ga) {
+    unsigned num_lines = ga->ir.num_lines;
+    unsigned num_workers = ga->num_threads;
+    unsigned i;
+    int failed = 0;
+
+    if (num_workers < 2 || num_lines < GAT_PAR_MIN_LINES) {
+        return 0;
+    }
+    if (!gat_par_alloc (ga, num_workers)) {
+        return 0;
+    }
+
+    for (i = 0; i < num_workers; i++) {
+        gat_par_begin (ga, ga->workers + i, 
+                       (unsigned)((uint64_t)num_lines * i / num_workers), 
+                       (unsigned)((uint64_t)num_lines * (i + 1) / num_workers));
+    }
+    gat_par_run (gat_par_encode_lines, ga->workers, sizeof(gat_par_worker), num_workers);
+
+    for (i = 0; i < num_workers; i++) {
+        gat_par_end (ga, ga->workers + i);
+        failed|= ga->workers[i].failed;
+    }
+    return !failed;
+}
+
+/* reports a diagnostic of a worker; line_base is added to its line no */
+static void gat_par_replay (gat *ga, const gat_par_worker *worker, 
+                            const gat_par_diag *diag, uint32_t line_base) {
+    ga->line_num = line_base + diag->line_num;
+    if (diag->warning) {
+        gat_warning (ga, diag->err_no, "%s", worker->text + diag->text);
+    } else {
+        gat_error (ga, diag->err_no, "%s", worker->text + diag->text);
+    }
+}
+
+/* tests if directives found on the current line define a macro, include a 
+   file or open or close an IF block; lines after them can't be scanned out of 
+   order */
+static int gat_par_serial_only (gat *ctx, const int *found, unsigned num_found) {
+    unsigned k;
+
+    for (k = 0; k < num_found; k++) {
+        switch (ctx->dirt_table[found[k]].token) {
+        case GAT_MACRO:
+        case GAT_INCLUDE:
+        case GAT_IF:
+        case GAT_IFDEF:
+        case GAT_ELSE:
+        case GAT_ENDIF:
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* scans the lines of the worker's chunk into its IR. instructions are scanned 
+   and sized as gat_scan_line does; directives and lines raising diagnostics 
+   are recorded as events for the ordered merge, with the code size of the 
+   lines since the previous event. */
+static void gat_par_scan_chunk (gat_par_worker *worker) {
+    gat *ctx = worker->ctx;
+    const char *pos = worker->begin;
+    const char *end = worker->end;
+    int found[GAT_MAX_TOKENS];
+    uint32_t line_num = 0, bytes = 0;
+    uint64_t tokens = 0;
+
+    while (pos < end && !worker->failed) {
+        const char *view = pos;
+        const char *eol = (const char *)memchr (view, '\n', end - view);
+        unsigned index, num_diags;
+        uint8_t kind = GAT_LINE_NONE;
+        size_t length;
+
+        if (eol == NULL) {
+            eol = end;
+        }
+        pos = eol + (eol < end ? 1 : 0);
+        ++line_num;
+
+        length = gat_trim_view (&view, eol - view);
+        if (length == 0) {
+            continue;
+        }
+        ctx->line = view;
+        ctx->line_len = length;
+        ctx->line_num = line_num;
+
+        index = ctx->ir.num_lines;
+        num_diags = worker->num_diags;
+        worker->current = index;
+
+        gat_tokenize_errors (ctx, gat_tokenize_text (view, length, ctx->arr_raw_tokens, 
+                                                     &ctx->num_tokens));
+        gat_prepare_tokens (ctx);
+
+        if (ctx->num_tokens > 0) {
+            uint64_t kw_lookups = ctx->stats.kw_lookups;
+
+            unsigned num_found = gat_find_directives (ctx, found);
+
+            /* lines after a MACRO belong to its body; such sources scan serially */
+            if (gat_par_serial_only (ctx, found, num_found)) {
+                worker->failed = 1;
+                break;
+            }
+            if (num_found > 0) {
+                /* the merge looks the directives up again */
+                ctx->stats.kw_lookups = kw_lookups;
+                gat_ir_add_line (ctx, GAT_LINE_DIRT, -1);
+                kind = GAT_LINE_DIRT;
+            } else {
+                int instr_index = gat_search_instr (ctx, ctx->arr_raw_tokens[0].string, 
+                                                    ctx->arr_raw_tokens[0].length);
+                if (instr_index == -1) {
+                    gat_error (ctx, GAT_ERR_INVALID_INSTRUCTION, "invalid instruction : %s", 
+                                gat_token_str(ctx, 0));
+                } else {
+                    const gat_instr *instr = &ctx->instr_table[instr_index];
+                    int scanned = 0, compiled;
+
+                    /* expressions with symbols keep code in the context; 
+                       such sources scan serially */
+                    compiled = gat_expr_operands (ctx, 0);
+                    if (compiled == -1) {
+                        worker->failed = 1;
+                        break;
+                    }
+                    if (compiled) {
+                        scanned = gat_scan_instruction (ctx, instr);
+                    }
+
+                    if (compiled && instr->num_tokens == ctx->num_tokens - 1) {
+                        gat_ir_add_line (ctx, GAT_LINE_INSTR, instr_index);
+                        ctx->ir.lines[index].bin_size = (uint8_t)(scanned ? ctx->bin_size : 0);
+                        worker->ir_lines++;
+                        worker->ir_tokens+= ctx->num_tokens;
+                        kind = GAT_LINE_INSTR;
+                    }
+                }
+            }
+        }
+
+        tokens+= ctx->num_tokens;
+
+        if (worker->num_diags > num_diags || kind == GAT_LINE_DIRT) {
+            size_t capacity = worker->max_events;
+            gat_par_event *event;
+
+            if (kind == GAT_LINE_NONE) {
+                gat_ir_add_line (ctx, GAT_LINE_NONE, -1);
+            }
+            if ( !gat_par_grow ((void **)&worker->events, sizeof(gat_par_event), 
+                                worker->num_events + 1, &capacity, GAT_PAR_INIT_EVENTS) ) {
+                worker->failed = 1;
+                break;
+            }
+            worker->max_events = (unsigned)capacity;
+
+            event = worker->events + worker->num_events++;
+            event->index = index;
+            event->bytes = bytes;
+            event->tokens = tokens;
+            event->kw_lookups = ctx->stats.kw_lookups;
+            bytes = 0;
+        } else if (kind == GAT_LINE_INSTR) {
+            bytes+= ctx->ir.lines[index].bin_size;
+        }
+    }
+
+    worker->num_lines = line_num;
+    worker->tail_bytes = bytes;
+    worker->num_tokens = tokens;
+}
+
+/* scans a chunk on a worker thread. running out of memory unwinds here; the 
+   scan has its own frame, so no local is changed between setjmp and longjmp. */
+static void gat_par_scan_lines (void *arg) {
+    gat_par_worker *worker = (gat_par_worker *)arg;
+
+    if (setjmp (worker->ctx->fatal_jmp) != 0) {
+        worker->failed = 1;
+        return;
+    }
+    worker->ctx->fatal_jmp_armed = 1;
+    gat_par_scan_chunk (worker);
+}
+
+/* adds the code size of chunk lines [first, last) to the offset */
+static void gat_par_advance (gat *ga, const gat_par_chunk *chunk, unsigned first, 
+                             unsigned last, uint32_t bytes) {
+    const gat_ir *ir = &chunk->worker->ir;
+    unsigned i;
+
+    /* find the line that runs out of range */
+    if (ga->offset + bytes > 65536) {
+        for (i = first; i < last; i++) {
+            const gat_line *line = ir->lines + i;
+
+            if (ga->offset + line->bin_size > 65536) {
+                ga->line_num = chunk->line_num + line->line_num;
+                ga->stats.lines = ga->line_num;
+                gat_fatal_error (ga, GAT_ERR_OFFSET_OUT_OF_RANGE, "offset out of range");
+            }
+            ga->offset+= line->bin_size;
+        }
+        return;
+    }
+    ga->offset+= bytes;
+}
+
+/* runs the events of the chunks in source order; directives are scanned with 
+   the offset summed up to them. counters of the workers are added up to the 
+   line reached, so they match serial scanning when END stops the source. 
+   returns the number of chunks before END. */
+static unsigned gat_par_merge (gat *ga, gat_par_chunk *chunks, unsigned num_chunks) {
+    uint32_t line_num = 0;
+    unsigned c, e, d, i;
+
+    for (c = 0; c < num_chunks; c++) {
+        gat_par_chunk *chunk = chunks + c;
+        gat_par_worker *worker = chunk->worker;
+        uint64_t tokens = 0, kw_lookups = 0;
+        unsigned next = 0;
+
+        chunk->limit = worker->ir.num_lines;
+        chunk->line_num = line_num;
+        chunk->offset = ga->offset;
+
+        for (e = 0, d = 0; e < worker->num_events; e++) {
+            const gat_par_event *event = worker->events + e;
+            gat_line *line = worker->ir.lines + event->index;
+            int flag_dirt, flag_end;
+
+            gat_par_advance (ga, chunk, next, event->index, event->bytes);
+            next = event->index + 1;
+
+            ga->line_num = line_num + line->line_num;
+            ga->stats.lines = ga->line_num;
+            ga->stats.tokens+= event->tokens - tokens;
+            ga->stats.kw_lookups+= event->kw_lookups - kw_lookups;
+            tokens = event->tokens;
+            kw_lookups = event->kw_lookups;
+
+            for (; d < worker->num_diags && worker->diags[d].index == event->index; d++) {
+                gat_par_replay (ga, worker, worker->diags + d, line_num);
+            }
+
+            if (line->kind == GAT_LINE_DIRT) {
+                gat_ir_load_from (ga, &worker->ir, line);
+                ga->line_num = line_num + line->line_num;
+
+                /* a retained ORG lands in the scratch IR; the chunk line 
+                   becomes the ORG line */
+                gat_ir_reset (&ga->ir);
+                gat_scan_directives (ga, &flag_dirt, &flag_end);
+                if (ga->ir.num_lines > 0) {
+                    line->kind = GAT_LINE_ORG;
+                    line->offset = ga->offset;
+                    worker->ir_lines++;
+                    worker->ir_tokens+= line->num_tokens;
+                }
+
+                if (flag_end) {
+                    chunk->limit = event->index;
+                    worker->ir_lines = worker->ir_tokens = 0;
+                    for (i = 0; i < chunk->limit; i++) {
+                        line = worker->ir.lines + i;
+                        if (line->kind == GAT_LINE_INSTR || line->kind == GAT_LINE_ORG) {
+                            worker->ir_lines++;
+                            worker->ir_tokens+= line->num_tokens;
+                        }
+                    }
+                    return c + 1;
+                }
+            } else if (line->kind == GAT_LINE_INSTR) {
+                gat_par_advance (ga, chunk, event->index, event->index + 1, line->bin_size);
+            }
+        }
+        gat_par_advance (ga, chunk, next, worker->ir.num_lines, worker->tail_bytes);
+
+        line_num+= worker->num_lines;
+        ga->line_num = line_num;
+        ga->stats.lines = line_num;
+        ga->stats.tokens+= worker->num_tokens - tokens;
+        ga->stats.kw_lookups+= worker->ctx->stats.kw_lookups - kw_lookups;
+    }
+    return num_chunks;
+}
+
+/* copies the IR and ORG lines of a chunk into the IR of the source, placing 
+   their code offsets */
+static void gat_par_copy_lines (void *arg) {
+    const gat_par_chunk *chunk = (const gat_par_chunk *)arg;
+    const gat_ir *ir = &chunk->worker->ir;
+    gat_line *out = chunk->ir->lines + chunk->line_base;
+    unsigned token_base = chunk->token_base;
+    uint32_t offset = chunk->offset;
+    unsigned i;
+
+    for (i = 0; i < chunk->limit; i++) {
+        const gat_line *line = ir->lines + i;
+
+        if (line->kind == GAT_LINE_ORG) {
+            offset = line->offset;
+        } else if (line->kind != GAT_LINE_INSTR) {
+            continue;
+        }
+
+        *out = *line;
+        out->line_num+= chunk->line_num;
+        out->offset = offset;
+        out->token_base = token_base;
+        out->bin_size = 0;
+        memcpy (chunk->ir->tokens + token_base, ir->tokens + line->token_base, 
+                line->num_tokens * sizeof(gat_ir_token));
+        token_base+= line->num_tokens;
+        offset+= line->bin_size;
+        ++out;
+    }
+}
+
+/* scans the source on worker threads. each worker tokenizes, classifies and 
+   sizes the lines of a chunk; the chunks are then merged in source order, 
+   running directives with offsets summed from the code size between them, 
+   and copied into the IR in parallel. messages, symbols and the IR come out 
+   exactly as in serial scanning. returns 0 without scanning a line if the 
+   source is to be scanned serially. */
+int gat_par_scan (gat *ga) {
+    gat_par_chunk chunks [GAT_PAR_MAX_THREADS];
+    const char *src = ga->src;
+    const char *src_end = ga->src + ga->src_size;
+    unsigned num_workers = ga->num_threads;
+    size_t chunk_size = ga->src_size / (num_workers > 0 ? num_workers : 1);
+    unsigned num_chunks, num_lines, num_tokens, i;
+    jmp_buf outer_jmp;
+    gat_ir source_ir;
+    int failed = 0;
+
+    if ( ga->engine != GAT_ENGINE_TWO_PASS || num_workers < 2 || 
+         ga->src_size < GAT_PAR_MIN_SOURCE ) {
+        return 0;
+    }
+    if (!gat_par_alloc (ga, num_workers)) {
+        return 0;
+    }
+
+    /* split source in chunks of whole lines */
+    for (i = 0; i < num_workers; i++) {
+        gat_par_worker *worker = ga->workers + i;
+        const char *end = src_end;
+
+        gat_par_begin (ga, worker, 0, 0);
+        worker->ctx->ir = worker->ir;
+        gat_ir_reset (&worker->ctx->ir);
+        worker->num_events = 0;
+        worker->ir_lines = worker->ir_tokens = 0;
+
+        worker->begin = i == 0 ? src : ga->workers[i - 1].end;
+        if (i + 1 < num_workers && (size_t)(worker->begin - src) < chunk_size * (i + 1)) {
+            const char *split = src + chunk_size * (i + 1);
+            const char *eol = (const char *)memchr (split, '\n', src_end - split);
+            end = eol != NULL ? eol + 1 : src_end;
+        } else if (i + 1 < num_workers) {
+            end = worker->begin;
+        }
+        worker->end = end;
+
+        chunks[i].worker = worker;
+        chunks[i].ir = &ga->ir;
+    }
+
+    gat_par_run (gat_par_scan_lines, ga->workers, sizeof(gat_par_worker), num_workers);
+
+    for (i = 0; i < num_workers; i++) {
+        ga->workers[i].ir = ga->workers[i].ctx->ir;
+        failed|= ga->workers[i].failed;
+    }
+    if (failed) {
+        return 0;
+    }
+
+    /* directives run on a scratch IR; a fatal error restores the source IR 
+       before it unwinds the engine */
+    source_ir = ga->ir;
+    gat_ir_init (&ga->ir);
+    memcpy (outer_jmp, ga->fatal_jmp, sizeof(jmp_buf));
+    if (setjmp (ga->fatal_jmp) != 0) {
+        gat_ir_free (&ga->ir);
+        ga->ir = source_ir;
+        memcpy (ga->fatal_jmp, outer_jmp, sizeof(jmp_buf));
+        longjmp (ga->fatal_jmp, 1);
+    }
+
+    num_chunks = gat_par_merge (ga, chunks, num_workers);
+
+    gat_ir_free (&ga->ir);
+    ga->ir = source_ir;
+    memcpy (ga->fatal_jmp, outer_jmp, sizeof(jmp_buf));
+
+    /* place the chunks in the IR by the running sum of their sizes */
+    num_lines = ga->ir.num_lines;
+    num_tokens = ga->ir.num_tokens;
+    for (i = 0; i < num_chunks; i++) {
+        chunks[i].line_base = num_lines;
+        chunks[i].token_base = num_tokens;
+        num_lines+= chunks[i].worker->ir_lines;
+        num_tokens+= chunks[i].worker->ir_tokens;
+    }
+    gat_ir_reserve (ga, num_lines, num_tokens);
+    gat_par_run (gat_par_copy_lines, chunks, sizeof(gat_par_chunk), num_chunks);
+    ga->ir.num_lines = num_lines;
+    ga->ir.num_tokens = num_tokens;
+
+    ga->src_pos = ga->src_size;
+    return 1;
+}
+
+/* reports diagnostics the workers raised on IR line index. lines must be 
+   reported in order, starting with a zeroed cursor. */
+void gat_par_report (gat *ga, unsigned index, gat_par_cursor *cursor) {
+    while (cursor->worker < ga->num_threads) {
+        const gat_par_worker *worker = ga->workers + cursor->worker;
+        const gat_par_diag *diag;
+
+        if (cursor->diag == worker->num_diags) {
+            if (worker->last > index) {
+                return;
+            }
+            ++cursor->worker;
+            cursor->diag = 0;
+            continue;
+        }
+
+        diag = worker->diags + cursor->diag;
+        if (diag->index != index) {
+            return;
+        }
+        ++cursor->diag;
+        ga->file = ga->ir.lines[index].file;
+        gat_par_replay (ga, worker, diag, 0);
+    }
+}
+
+/* frees workers */
+void gat_par_free (gat *ga) {
+    unsigned i;
+
+    for (i = 0; i < ga->num_workers; i++) {
+        free (ga->workers[i].ctx);
+        free (ga->workers[i].diags);
+        free (ga->workers[i].text);
+        free (ga->workers[i].events);
+        gat_ir_free (&ga->workers[i].ir);
+    }
+    free (ga->workers);
+    ga->workers = NULL;
+    ga->num_workers = 0;
+}
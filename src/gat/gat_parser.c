@@ -24,7 +24,17 @@
 #include "gat_core.h"
 #include "gat_str.h"
 #include "gat_io.h"
+#include "gat_ir.h"
+#include "gat_image.h"
+#include "gat_macro.h"
+#include "gat_include.h"
+#include "gat_cond.h"
+#include "gat_expr.h"
+#include "gat_tokenizer.h"
 #include "gat_err.h"
+#include "gat_sysutils.h"
+#include "gat_pipeline.h"
+#include "gat_parallel.h"
 #include <assert.h>
 
 #ifdef _DEBUG
@@ -44,25 +54,28 @@
 
 /* test routines; these are silent and do not generate any errors */
 
-/* tests for a byte vlaue from literal or id */
-int gat_test_byte (gat *ga, const char *strtoken) {
+/* tests for a byte vlaue from literal, id or expression */
+int gat_test_byte (gat *ga, unsigned index) {
     return (
-        gat_is_byte(strtoken) ||
-        gat_is_id(strtoken)
+        ga->arr_raw_tokens[index].type == GAT_TOK_EXPR ||
+        gat_token_is_byte(ga, index) ||
+        gat_is_id(gat_token_str(ga, index))
         );
 }
 
-/* tests for a double value from literal, label or id */
-int gat_test_dbl (gat *ga, const char *strtoken) {
+/* tests for a double value from literal, label, id or expression */
+int gat_test_dbl (gat *ga, unsigned index) {
     return (
-        gat_is_dbl(strtoken) ||
-        gat_is_label(strtoken) ||
-        gat_is_id(strtoken)
+        ga->arr_raw_tokens[index].type == GAT_TOK_EXPR ||
+        gat_token_is_dbl(ga, index) ||
+        gat_is_label(gat_token_str(ga, index)) ||
+        gat_is_id(gat_token_str(ga, index))
         );
 }
 
 /* tests for specific token */
-int gat_test_token (gat *ga, const char *strtoken, int optype) {
+int gat_test_token (gat *ga, unsigned index, int optype) {
+    const char *strtoken = gat_token_str(ga, index);
     switch (optype) {
     case GAT_OPRND_REG8:
         return ga->arch->is_reg8(strtoken);
@@ -74,10 +87,10 @@ int gat_test_token (gat *ga, const char *strtoken, int optype) {
         return gat_is_symbol(strtoken[0]);
 
     case GAT_OPRND_BYTE:
-        return gat_test_byte(ga, strtoken);
+        return gat_test_byte(ga, index);
         
     case GAT_OPRND_DBL:
-        return gat_test_dbl(ga, strtoken);
+        return gat_test_dbl(ga, index);
 
     default:
         GAT_ASSERTE(0,\
@@ -89,9 +102,20 @@ int gat_test_token (gat *ga, const char *strtoken, int optype) {
 
 /* parse routines; these generate errors when input does not match */
 
-int gat_parse_byte (gat *ga, const char *strtoken, uint8_t *value) {
-    if (gat_is_byte(strtoken)) {
-        *value = gat_cbyte(strtoken);
+int gat_parse_byte (gat *ga, unsigned index, uint8_t *value) {
+    const char *strtoken = gat_token_str(ga, index);
+    if (ga->arr_raw_tokens[index].type == GAT_TOK_EXPR) {
+        int32_t dbl;
+        if (gat_expr_eval (ga, index, &dbl)) {
+            if (dbl < GAT_MIN_BYTE || dbl > GAT_MAX_BYTE) {
+                gat_error (ga, GAT_ERR_INVALID_CONVERSION, "cannot convert dbl to byte : %s", strtoken);
+            } else {
+                *value = (uint8_t)((uint32_t)dbl & GAT_MAX_BYTE);
+                return 1;
+            }
+        }
+    } else if (gat_token_is_byte(ga, index)) {
+        *value = (uint8_t)gat_token_value(ga, index);
         return 1;
     } else if (gat_is_id(strtoken)) {
         /* search for id */
@@ -114,9 +138,16 @@ int gat_parse_byte (gat *ga, const char *strtoken, uint8_t *value) {
     return 0; /* failed to parse a byte */
 }
 
-int gat_parse_dbl (gat *ga, const char *strtoken, uint16_t *value) {
-    if (gat_is_dbl(strtoken)) {
-        *value = gat_cdbl (strtoken);
+int gat_parse_dbl (gat *ga, unsigned index, uint16_t *value) {
+    const char *strtoken = gat_token_str(ga, index);
+    if (ga->arr_raw_tokens[index].type == GAT_TOK_EXPR) {
+        int32_t dbl;
+        if (gat_expr_eval (ga, index, &dbl)) {
+            *value = (uint16_t)((uint32_t)dbl & GAT_MAX_DBL);
+            return 1;
+        }
+    } else if (gat_token_is_dbl(ga, index)) {
+        *value = (uint16_t)gat_token_value(ga, index);
         return 1;
     } else if (gat_is_id(strtoken)) {
         int index;
@@ -142,7 +173,8 @@ int gat_parse_dbl (gat *ga, const char *strtoken, uint16_t *value) {
 }
 
 /* parses token specified in optype parameter and returns the value */
-int gat_parse_token (gat *ga, const char *strtoken, int optype, void *pvalue) {
+int gat_parse_token (gat *ga, unsigned index, int optype, void *pvalue) {
+    const char *strtoken = gat_token_str(ga, index);
     switch (optype) {
     /* check for 8 bit reg */
     case GAT_OPRND_REG8:
@@ -172,18 +204,22 @@ int gat_parse_token (gat *ga, const char *strtoken, int optype, void *pvalue) {
         }
         break;
 
-    /* check for byte constant or id */
+    /* check for byte constant or id; an expression has reported its own error */
     case GAT_OPRND_BYTE:
-        if (!gat_parse_byte (ga, strtoken, (uint8_t *)pvalue)) {
-            gat_error (ga, GAT_ERR_BYTE_EXPECTED, "byte expected");
+        if (!gat_parse_byte (ga, index, (uint8_t *)pvalue)) {
+            if (ga->arr_raw_tokens[index].type != GAT_TOK_EXPR) {
+                gat_error (ga, GAT_ERR_BYTE_EXPECTED, "byte expected");
+            }
             return 0;
         }
         break;
 
     /* check for word constant, id or label */
     case GAT_OPRND_DBL:
-        if (!gat_parse_dbl (ga, strtoken, (uint16_t *)pvalue)) {
-            gat_error (ga, GAT_ERR_WORD_EXPECTED, "word expected");
+        if (!gat_parse_dbl (ga, index, (uint16_t *)pvalue)) {
+            if (ga->arr_raw_tokens[index].type != GAT_TOK_EXPR) {
+                gat_error (ga, GAT_ERR_WORD_EXPECTED, "word expected");
+            }
             return 0;
         }
         break;
@@ -203,15 +239,19 @@ int gat_is_reg (gat *ga, const char *token) {
         );
 }
 
-/* scans an ORG directive -> ORG dbl | id */
+/* scans an ORG directive -> ORG dbl | id | expr */
 int gat_parse_org (gat *ga) {
-    if ( gat_is_dbl(ga->arr_tokens[1]) ) {
+    /* ORG lines retained by parallel scanning keep their expression tokens */
+    if ( ga->num_tokens > 2 && !gat_expr_value (ga, 1) ) {
+        return 0;
+    }
+    if ( gat_token_is_dbl(ga, 1) ) {
         /* set from word constant */
-        ga->org = gat_cdbl(ga->arr_tokens[1]);
+        ga->org = gat_token_value(ga, 1);
         ga->offset = ga->org;
-    } else if ( gat_is_id(ga->arr_tokens[1])) {
+    } else if ( gat_is_id(gat_token_str(ga, 1))) {
         /* search for id */
-        int index = gat_search_id (ga, ga->arr_tokens[1]);
+        int index = gat_search_id (ga, gat_token_str(ga, 1));
         if (index == -1) {
             gat_error (ga, GAT_ERR_CONST_EXPECTED, "constant expected : org");
             return 0;
@@ -223,7 +263,7 @@ int gat_parse_org (gat *ga) {
             ga->offset = ga->org;
         }
     } else {
-        gat_error (ga, GAT_ERR_CONST_EXPECTED, "constant expected : %s", ga->arr_tokens[0]);
+        gat_error (ga, GAT_ERR_CONST_EXPECTED, "constant expected : %s", gat_token_str(ga, 0));
         return 0;
     }
 
@@ -233,46 +273,46 @@ int gat_parse_org (gat *ga) {
 /* parse EQU directive -> id EQU (byte | word | id) */
 int gat_parse_equ (gat *ga) {
     /* parse id at token 0 */
-    if ( !gat_is_id (ga->arr_tokens[0]) ) {
+    if ( !gat_is_id (gat_token_str(ga, 0)) ) {
         gat_error (ga, GAT_ERR_INVALID_ID, "invalid identifier : %s", 
-                    ga->arr_tokens[0]);
+                    gat_token_str(ga, 0));
         return 0;
     } 
     /* can't use register names for ids */
-    if ( gat_is_reg (ga, ga->arr_tokens[0]) ) {
+    if ( gat_is_reg (ga, gat_token_str(ga, 0)) ) {
         gat_error (ga, GAT_ERR_RESERVED_NAME, "use of register name as identifier : %s", 
-                    ga->arr_tokens[0]);
+                    gat_token_str(ga, 0));
         return 0;
     }
 
     /* parse value at token 2 */
-    if ( gat_is_byte(ga->arr_tokens[2]) ) {
+    if ( gat_token_is_byte(ga, 2) ) {
         /* define byte id */
-        gat_define_id (ga, ga->arr_tokens[0], 
-                        gat_cdbl(ga->arr_tokens[2]), 
+        gat_define_id (ga, gat_token_str(ga, 0), 
+                        (uint16_t)gat_token_value(ga, 2), 
                         GAT_IDTYPE_BYTE);
-    } else if ( gat_is_dbl (ga->arr_tokens[2]) ) {
+    } else if ( gat_token_is_dbl (ga, 2) ) {
         /* define dbl id */
-        gat_define_id (ga, ga->arr_tokens[0], 
-                        gat_cdbl(ga->arr_tokens[2]), 
+        gat_define_id (ga, gat_token_str(ga, 0), 
+                        (uint16_t)gat_token_value(ga, 2), 
                         GAT_IDTYPE_DBL);
-    } else if  ( gat_is_id(ga->arr_tokens[2]) ) {
+    } else if  ( gat_is_id(gat_token_str(ga, 2)) ) {
         /* search for id */
-        int index = gat_search_id (ga, ga->arr_tokens[2]);        
+        int index = gat_search_id (ga, gat_token_str(ga, 2));        
         if (index == -1) {
             /* id not found */
             gat_error (ga, GAT_ERR_UNDEFINED_ID, "undefined label or identifier : %s", 
-                        ga->arr_tokens[2]);            
+                        gat_token_str(ga, 2));            
             return 0;
         } else {
             /* define same type id */
-            gat_define_id (ga, ga->arr_tokens[0], 
+            gat_define_id (ga, gat_token_str(ga, 0), 
                             ga->arr_ids[index].data, 
                             ga->arr_ids[index].idtype);
         }
     } else {
         gat_error (ga, GAT_ERR_CONST_EXPECTED, "constant expected : %s", 
-                    ga->arr_tokens[0]);
+                    gat_token_str(ga, 0));
         return 0;
     }
 
@@ -282,46 +322,70 @@ int gat_parse_equ (gat *ga) {
 /* parses a label -> id : */
 int gat_parse_label (gat *ga) {
     /* parse id at token 0 */
-    if ( !gat_is_id (ga->arr_tokens[0]) ) {
+    if ( !gat_is_id (gat_token_str(ga, 0)) ) {
         gat_error (ga, GAT_ERR_INVALID_ID, "invalid label-identifier : %s", 
-                    ga->arr_tokens[0]);
+                    gat_token_str(ga, 0));
         return 0;
     } 
 
     /* can't use register names for ids */
-    if ( gat_is_reg(ga, ga->arr_tokens[0]) ) {
+    if ( gat_is_reg(ga, gat_token_str(ga, 0)) ) {
         gat_error (ga, GAT_ERR_RESERVED_NAME, "use of register name as label-identifier : %s", 
-                    ga->arr_tokens[0]);
+                    gat_token_str(ga, 0));
         return 0;
     } 
     
     /* define label */
-    gat_define_label (ga, ga->arr_tokens[0], (uint16_t)ga->offset);
+    gat_define_label (ga, gat_token_str(ga, 0), (uint16_t)ga->offset);
     return 1;
 }
 
+/* looks up directive commands of the current line into found in directive 
+   table order; returns number of directives found */
+unsigned gat_find_directives (gat *ga, int *found) {
+    unsigned num_found = 0, t, k;
+
+    /* look up the tokens that can hold a directive command */
+    for (t = 0; t < ga->num_tokens && t <= ga->max_dirt_token_index; t++) {
+        int code = gat_search_keyword (ga, ga->arr_raw_tokens[t].string, 
+                                        ga->arr_raw_tokens[t].length);
+        if (code != GAT_KW_NONE && (code & GAT_KW_DIRT) && 
+            ga->dirt_table[code & ~GAT_KW_DIRT].token_index == t) {
+            /* keep directive table order */
+            for (k = num_found; k > 0 && found[k - 1] > (code & ~GAT_KW_DIRT); k--) {
+                found[k] = found[k - 1];
+            }
+            found[k] = code & ~GAT_KW_DIRT;
+            ++num_found;
+        }
+    }
+    return num_found;
+}
+
 /* scans for directives */
 void gat_scan_directives (gat *ga, int *dirt, int *end) {
-    unsigned i;
+    int found[GAT_MAX_TOKENS];
+    unsigned num_found, k, i, first;
 
     *dirt = *end = 0;
 
-    for (i = 0; i < ga->len_dirt_table; i++) {
-        if (ga->dirt_table[i].token_index >= ga->num_tokens) {
-            continue; /* not enough tokens to parse command */
-        }
+    num_found = gat_find_directives (ga, found);
 
-        /* test for command */
-        if (!gat_strcmpi(ga->arr_tokens[ga->dirt_table[i].token_index],
-                        ga->dirt_table[i].command)) {
-            continue;
-        }
+    for (k = 0; k < num_found; k++) {
+        i = found[k];
 
         /* set directive flag */
         *dirt = 1;
 
+        /* operand expressions of EQU and ORG are evaluated now */
+        first = ga->dirt_table[i].token == GAT_EQU ? 2 : 1;
+        if ( (ga->dirt_table[i].token == GAT_EQU || ga->dirt_table[i].token == GAT_ORG) && 
+             ga->num_tokens > first + 1 && !gat_expr_value (ga, first) ) {
+            return;
+        }
+
         /* check for number of tokens */
-        if (ga->num_tokens != ga->dirt_table[i].num_tokens) {
+        if (ga->dirt_table[i].num_tokens != 0 && ga->num_tokens != ga->dirt_table[i].num_tokens) {
             const char *name = *ga->dirt_table[i].command == ':'
                                 ? "label" : ga->dirt_table[i].command;
             gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid number of operands : %s", 
@@ -334,11 +398,26 @@ void gat_scan_directives (gat *ga, int *dirt, int *end) {
         case GAT_END:
             *end = 1; break;
         case GAT_ORG:               
-            gat_parse_org (ga); break;
+            gat_parse_org (ga); 
+            /* retain ORG for assembly phase; it is re-parsed there */
+            gat_ir_add_line (ga, GAT_LINE_ORG, -1);
+            break;
         case GAT_LABEL:
             gat_parse_label (ga); break;
         case GAT_EQU:
             gat_parse_equ (ga); break;
+        case GAT_MACRO:
+            gat_parse_macro (ga); break;
+        case GAT_ENDM:
+            gat_error (ga, GAT_ERR_MACRO_NESTING, "endm without macro");
+            break;
+        case GAT_INCLUDE:
+            gat_parse_include (ga, end); break;
+        case GAT_IF:
+        case GAT_IFDEF:
+        case GAT_ELSE:
+        case GAT_ENDIF:
+            gat_parse_cond (ga, ga->dirt_table[i].token); break;
         default:
             GAT_ASSERTE(0, \
             "unsupported directive found in directive table.");
@@ -346,45 +425,44 @@ void gat_scan_directives (gat *ga, int *dirt, int *end) {
     }
 }
 
-/* parse directives; silent on assembly */
-void gat_parse_directives (gat *ga, int *dirt, int *end) {
-    unsigned i;
-
-    *dirt = *end = 0;
-
-    for (i = 0; i < ga->len_dirt_table; i++) {
-        if (ga->dirt_table[i].token_index >= ga->num_tokens) {
-            continue; /* not enough tokens to parse command */
-        }
-
-        /* test for command */
-        if (!gat_strcmpi(ga->arr_tokens[ga->dirt_table[i].token_index],
-                        ga->dirt_table[i].command)) {
-            continue;
-        }
-
-        /* set directive flag */
-        *dirt = 1;
-
-        /* check for number of tokens */
-        if (ga->num_tokens != ga->dirt_table[i].num_tokens) {
-            return; /* error reporting already done in pass #1 */
-        }
+/* cooks operands whose values are already known during analysis so that 
+   assembly phase does not need to parse them again */
+static void gat_cook_operands (gat *ga, const gat_instr *instr) {
+    int i;
 
-        /* parse directive */
-        switch (ga->dirt_table[i].token) {
-        case GAT_END:
-            *end = 1; break;
+    for (i = 0; i < instr->num_tokens; i++) {
+        const uint8_t options = instr->type_options[i];
+        uint16_t *pvalue = &ga->arr_cooked_tokens[i + 1];
+        int cooked = 1;
 
-        case GAT_ORG:
-            if (gat_parse_org (ga)) {
-                unsigned i = 1; /* output at ios[1] */
-                for (; i < ga->num_ios; i++) {
-                    ga->ios[i].emitter (ga, ga->ios + i, GAT_EMIT_SET_ORG);
-                }
+        switch (instr->type_operands[i]) {
+        case GAT_OPRND_REG8:
+            *pvalue = ga->arch->creg8(gat_token_str(ga, i + 1));
+            break;
+        case GAT_OPRND_REG16:
+            *pvalue = ga->arch->creg16(gat_token_str(ga, i + 1));
+            break;
+        case GAT_OPRND_SYMBOL:
+            *pvalue = (uint16_t)options & 0x00FF;
+            cooked = (gat_token_str(ga, i + 1)[0] == (char)options);
+            break;
+        case GAT_OPRND_BYTE:
+            cooked = gat_token_is_byte(ga, i + 1);
+            if (cooked) {
+                *pvalue = (uint16_t)gat_token_value(ga, i + 1);
             }
             break;
+        case GAT_OPRND_DBL:
+            cooked = gat_token_is_dbl(ga, i + 1);
+            if (cooked) {
+                *pvalue = (uint16_t)gat_token_value(ga, i + 1);
+            }
+            break;
+        default:
+            cooked = 0; /* ids and labels are resolved on assembly */
         }
+
+        ga->arr_token_class[i + 1] = cooked ? GAT_OPCLASS_CONST : GAT_OPCLASS_NONE;
     }
 }
 
@@ -397,7 +475,7 @@ int gat_scan_instruction (gat *ga, const gat_instr *instr) {
     /* check for required number of operands */
     if (instr->num_tokens != ga->num_tokens - 1) {
         gat_error (ga, GAT_ERR_INVALID_OPERANDS, "invalid number of operands : %s", 
-                    ga->arr_tokens[0]);
+                    gat_token_str(ga, 0));
         return 0;
     }
 
@@ -408,9 +486,9 @@ int gat_scan_instruction (gat *ga, const gat_instr *instr) {
     for (i = 0; i < instr->num_tokens; i++) {
         const int options = instr->type_operands[i];
         /* test token with operand and update g_bin_size */
-        if (!gat_test_token(ga, ga->arr_tokens[i + 1], options )) {
+        if (!gat_test_token(ga, i + 1, options )) {
             gat_error ( ga, GAT_ERR_TYPE_MISMATCH, "operand type mismatch : %s", 
-                        ga->arr_tokens[0] );
+                        gat_token_str(ga, 0) );
             return 0;
         }
     }
@@ -426,16 +504,17 @@ int gat_scan_instruction (gat *ga, const gat_instr *instr) {
     if ( !ga->arch->filter (ga) ) {
         gat_error (ga, 
             GAT_ERR_INVALID_INSTRUCTION,
-            "instruction not allowed; may be invalid operand(s) : %s", 
-            ga->str_line);
+            "instruction not allowed; may be invalid operand(s) : %.*s", 
+            (int)ga->line_len, ga->line);
         return 0;
     }
 
+    gat_cook_operands (ga, instr);
     return 1;
 }
 
-/* assembles the instruction */
-int gat_assemble_instruction (gat *ga, const gat_instr *instr) {
+/* generates code of the instruction into the bin buffer */
+int gat_gen_instruction (gat *ga, const gat_instr *instr) {
     int i;
         
     /* reset bin size */
@@ -454,14 +533,20 @@ int gat_assemble_instruction (gat *ga, const gat_instr *instr) {
         const uint8_t optype = instr->type_operands[i];
         const uint8_t options = instr->type_options[i];
 
+        /* operands cooked during analysis need no parsing */
+        if (ga->arr_token_class[i + 1] == GAT_OPCLASS_CONST) {
+            continue;
+        }
+
         /* set token parse options input */
         ga->arr_cooked_tokens[i + 1] = (uint16_t)options & 0x00FF;
 
         /* try to parse the token */
-        if ( !gat_parse_token (ga, ga->arr_tokens[i + 1], 
+        if ( !gat_parse_token (ga, i + 1, 
                                 optype, 
                                  (void *)&ga->arr_cooked_tokens[i + 1])
                                  ) {
+            ga->bin_size = 0;
             return 0; /* failed to parse token */
         }
     }
@@ -472,106 +557,309 @@ int gat_assemble_instruction (gat *ga, const gat_instr *instr) {
     /* Note: bin size is checked during analysis phase */
     
     if ( !ga->arch->filter (ga) ) {
+        ga->bin_size = 0;
         return 0; /* silent on assembly */
     }
 
+    return 1;
+}
+
+/* assembles the instruction */
+int gat_assemble_instruction (gat *ga, const gat_instr *instr) {
+    if (!gat_gen_instruction (ga, instr)) {
+        return 0;
+    }
+
     /* emit the code */
     gat_emit (ga);
 
     return 1;
 }
 
+/* tests if the symbols referenced by operands of the scanned instruction 
+   are all defined */
+static int gat_test_defined (gat *ga, const gat_instr *instr) {
+    int i;
+
+    for (i = 0; i < instr->num_tokens; i++) {
+        const char *strtoken;
+
+        if (ga->arr_token_class[i + 1] == GAT_OPCLASS_CONST) {
+            continue;
+        }
+        if (ga->arr_raw_tokens[i + 1].type == GAT_TOK_EXPR) {
+            if (!gat_expr_defined (ga, i + 1)) {
+                return 0;
+            }
+            continue;
+        }
+        strtoken = gat_token_str(ga, i + 1);
+        switch (instr->type_operands[i]) {
+        case GAT_OPRND_BYTE:
+            if (gat_search_id (ga, strtoken) == -1) {
+                return 0;
+            }
+            break;
+        case GAT_OPRND_DBL:
+            if (gat_search_label (ga, strtoken) == -1 && gat_search_id (ga, strtoken) == -1) {
+                return 0;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return 1;
+}
+
+/* single pass engine; generates code of the scanned instruction into its 
+   IR line or records a fixup when it references symbols defined later */
+static void gat_gen_line (gat *ga, const gat_instr *instr) {
+    gat_line *line = ga->ir.lines + ga->ir.num_lines - 1;
+
+    if (!gat_test_defined (ga, instr)) {
+        gat_ir_add_fixup (ga);
+    } else if (gat_gen_instruction (ga, instr)) {
+        memcpy (line->bin, ga->bin, ga->bin_size);
+        line->bin_size = (uint8_t)ga->bin_size;
+    }
+}
+
+/* scans the tokenized current line; END directive sets flag_end */
+void gat_scan_line (gat *ga, int *flag_end) {
+    int flag_dirt = 0;
+    int index;
+
+    /* lines of a macro body are recorded until ENDM */
+    if (gat_record_macro (ga)) {
+        return;
+    }
+
+    /* lines of a false IF block are skipped */
+    if (ga->cond_skip > 0 && gat_skip_line (ga, ga->arr_raw_tokens[0].string, 
+                                            ga->arr_raw_tokens[0].length)) {
+        return;
+    }
+
+    gat_scan_directives (ga, &flag_dirt, flag_end);
+    
+    if (!flag_dirt) {
+        index = gat_search_instr (ga, ga->arr_raw_tokens[0].string, 
+                                    ga->arr_raw_tokens[0].length);
+        if (index == -1) {
+            int macro = ga->num_macros > 0 ? gat_search_macro (ga, gat_token_str(ga, 0)) : -1;
+            if (macro != -1) {
+                gat_expand_macro (ga, macro, flag_end);
+            } else {
+                gat_error (ga, GAT_ERR_INVALID_INSTRUCTION, "invalid instruction : %s", 
+                            gat_token_str(ga, 0));
+            }
+        } else {
+            const gat_instr *instr = &ga->instr_table[index];
+            int scanned;
+
+            /* operands of several tokens are compiled into one each */
+            if (gat_expr_operands (ga, 1) == 0) {
+                return;
+            }
+            scanned = gat_scan_instruction (ga, instr);
+
+            /* retain the line for assembly phase; lines with wrong number of 
+               operands are silent on assembly and need not be retained */
+            if (instr->num_tokens == ga->num_tokens - 1) {
+                gat_ir_add_line (ga, GAT_LINE_INSTR, index);
+            }
+
+            if (scanned) {
+                if (ga->offset + ga->bin_size > 65536){
+                    gat_fatal_error (ga, GAT_ERR_OFFSET_OUT_OF_RANGE, "offset out of range");
+                }
+                ga->offset+= ga->bin_size;
+
+                if (ga->engine == GAT_ENGINE_SINGLE_PASS) {
+                    gat_gen_line (ga, instr);
+                }
+            }
+        }
+    }
+}
+
 /* scans assembly source; this corresponds to analysis phase. */
 int gat_scan (gat *ga) {
     int flag_end = 0;
-    int flag_dirt = 0;
-    int index;
     
     /* reset vars */
     ga->org = ga->offset = 0;
-
-    gat_print (ga, "scanning %s", ga->ios[0].path/*ga->input_path*/);
+    ga->macro_def = -1;
+    ga->macro_depth = 0;
+    ga->file = 0;
+    ga->include_stack[0] = 0;
+    ga->include_depth = 1;
+    gat_cond_reset (ga);
+
+    gat_print (ga, ga->engine == GAT_ENGINE_SINGLE_PASS ? "assembling %s" : "scanning %s", 
+                ga->ios[0].path/*ga->input_path*/);
+
+    /* large sources are scanned on worker threads, or read and tokenized on 
+       pipeline threads */
+    if (gat_par_scan (ga)) {
+        flag_end = 1;
+    } else if (ga->num_pipe_threads > 0 && ga->src_size >= GAT_PIPE_MIN_SOURCE && 
+               gat_pipe_scan (ga)) {
+        flag_end = 1;
+    }
     
     /* begin assembly loop */
-    while (!feof( ga->ios[0].fp) && !flag_end && !ga->fatal_error) {
-        /* read and parse the next line in input */
-        if (!gat_read_line(ga) || gat_tokenize_line (ga) == 0) {
+    while (!gat_end_of_source(ga) && !flag_end && !ga->fatal_error) {
+        /* read and parse the next line in input; lines of a false IF block 
+           are skipped before they are tokenized */
+        if (!gat_read_line(ga) || 
+            (ga->cond_skip > 0 && gat_skip_line (ga, ga->line, ga->line_len)) || 
+            gat_tokenize_line (ga) == 0) {
             continue;
         }
 
-        gat_scan_directives (ga, &flag_dirt, &flag_end);
-        
-        if (!flag_dirt) {
-            index = gat_search_instr (ga, ga->arr_tokens[0]);
-            if (index == -1) {
-                gat_error (ga, GAT_ERR_INVALID_INSTRUCTION, "invalid instruction : %s", 
-                            ga->arr_tokens[0]);
-            } else if (gat_scan_instruction (ga, &ga->instr_table[index])) {
-                if (ga->offset + ga->bin_size > 65536){
-                    gat_fatal_error (ga, GAT_ERR_OFFSET_OUT_OF_RANGE, "offset out of range");
-                }
-                ga->offset+= ga->bin_size;          
-            }
-        }
+        gat_scan_line (ga, &flag_end);
     }  /* end wile */
 
+    gat_end_macros (ga);
+    gat_end_conds (ga);
     return (ga->err_count == 0 ? 1 : 0);
 }
 
-/* assembles the source to machine code. */
+/* assembles the source to machine code. the source is not read again; 
+   lines retained in the IR during analysis phase are assembled instead. 
+   large sources are encoded on worker threads first and their code is 
+   written in line order here. */
 int gat_assemble (gat *ga) {
-    int flag_end = 0;
-    int flag_dirt = 0;
-    int index;
+    gat_par_cursor cursor = { 0, 0 };
+    int encoded;
+    unsigned i;
     
     /* reset vars */
     ga->org = ga->offset = 0;
     gat_print (ga, "assembling %s",  ga->ios[0].path);
-    
-    /* rewind the input file for assembly phase */
-    rewind ( ga->ios[0].fp);
 
-    /* emit begin */
-    for (index = 1; index < (int)ga->num_ios; index++) {
-        ga->ios[index].emitter (ga, &ga->ios[index], GAT_EMIT_BEGIN_ASSEMBLY);      
-    }
+    encoded = gat_par_encode (ga);
 
-    /* begin assembly loop */
-    while (!feof( ga->ios[0].fp) && !flag_end && !ga->fatal_error) {
-        /* read and parse the next line in input */
-        if (!gat_read_line(ga) || gat_tokenize_line (ga) == 0) {
-            continue;
-        }
+    /* emit begin; code is written into the memory image */
+    gat_image_begin (ga);
+    gat_emit_state (ga, GAT_EMIT_BEGIN_ASSEMBLY);
 
-        gat_parse_directives (ga, &flag_dirt, &flag_end);
-        
-        if (!flag_dirt) {
-            index = gat_search_instr (ga, ga->arr_tokens[0]);
-            if (index != -1) {
-                gat_assemble_instruction (ga, &ga->instr_table[index]);
+    /* begin assembly loop */
+    for (i = 0; i < ga->ir.num_lines && !ga->fatal_error; i++) {
+        const gat_line *line = ga->ir.lines + i;
+
+        if (line->kind == GAT_LINE_ORG) {
+            gat_ir_load_line (ga, line);
+            gat_parse_org (ga);
+        } else if (encoded) {
+            gat_par_report (ga, i, &cursor);
+            if (line->bin_size > 0) {
+                ga->line_num = line->line_num;
+                ga->file = line->file;
+                memcpy (ga->bin, line->bin, line->bin_size);
+                ga->bin_size = line->bin_size;
+                gat_emit (ga);
             }
+        } else {
+            gat_ir_load_line (ga, line);
+            gat_assemble_instruction (ga, &ga->instr_table[line->instr]);
         }
-    }  /* end wile */
+    }  /* end for */
 
     if (ga->err_count == 0) {
         /* emit end */
-        for (index = 1; index < (int)ga->num_ios; index++) {
-            ga->ios[index].emitter (ga, &ga->ios[index], GAT_EMIT_END_ASSEMBLY);
+        gat_emit_state (ga, GAT_EMIT_END_ASSEMBLY);
+    }
+
+    return (ga->err_count == 0 ? 1 : 0);
+}
+
+/* single pass engine; generates code of lines whose symbols were defined 
+   after them. runs at the end of source when all symbols are known. */
+void gat_patch_fixups (gat *ga) {
+    unsigned i;
+
+    for (i = 0; i < ga->ir.num_fixups; i++) {
+        gat_line *line = ga->ir.lines + ga->ir.fixups[i];
+
+        gat_ir_load_line (ga, line);
+        if (gat_gen_instruction (ga, &ga->instr_table[line->instr])) {
+            memcpy (line->bin, ga->bin, ga->bin_size);
+            line->bin_size = (uint8_t)ga->bin_size;
         }
     }
+    ga->ir.num_fixups = 0;
+}
+
+/* single pass engine; writes the code generated into the IR lines */
+int gat_emit_image (gat *ga) {
+    unsigned i;
+    
+    /* reset vars */
+    ga->org = ga->offset = 0;
+
+    /* emit begin; code is written into the memory image */
+    gat_image_begin (ga);
+    gat_emit_state (ga, GAT_EMIT_BEGIN_ASSEMBLY);
+
+    for (i = 0; i < ga->ir.num_lines && !ga->fatal_error; i++) {
+        const gat_line *line = ga->ir.lines + i;
+
+        if (line->kind == GAT_LINE_ORG) {
+            gat_ir_load_line (ga, line);
+            gat_parse_org (ga);
+        } else if (line->bin_size > 0) {
+            ga->line_num = line->line_num;
+            ga->file = line->file;
+            memcpy (ga->bin, line->bin, line->bin_size);
+            ga->bin_size = line->bin_size;
+            gat_emit (ga);
+        }
+    }
+
+    if (ga->err_count == 0) {
+        /* emit end */
+        gat_emit_state (ga, GAT_EMIT_END_ASSEMBLY);
+    }
 
     return (ga->err_count == 0 ? 1 : 0);
 }
 
-/* writes binary data to the output file */
-void gat_emit (gat *ga) {
+/* calls emitters of all outputs with the state */
+void gat_emit_state (gat *ga, gat_emitter_state state) {
+    uint64_t mark[2];
     unsigned i;
+
+    gat_stats_mark (ga, mark);
     for (i = 1; i < ga->num_ios; i++) {
-        ga->ios[i].emitter (ga, &ga->ios[i], GAT_EMIT_CODE);
+        ga->ios[i].emitter (ga, &ga->ios[i], state);
+    }
+    ga->stats.emit_calls+= ga->num_ios - 1;
+    gat_stats_phase (ga, GAT_PHASE_EMIT, mark);
+}
+
+/* writes code of the instruction into the memory image at the current offset. 
+   code overwriting earlier code is warned about once per overlapping stretch. */
+void gat_emit (gat *ga) {
+    gat_image *image = ga->image;
+    int overlap;
+
+    if (ga->offset + ga->bin_size > GAT_IMAGE_SIZE) {
+        gat_fatal_error (ga, GAT_ERR_OFFSET_OUT_OF_RANGE, "offset out of range");
+    }
+    overlap = gat_image_write (image, ga->offset, ga->bin, ga->bin_size, ga->line_num);
+    if (overlap && !image->overlapping) {
+        gat_warning (ga, GAT_WARN_CODE_OVERLAP, "code overlaps earlier code : %04Xh", 
+                     ga->offset);
     }
+    image->overlapping = overlap;
+    ga->offset+= ga->bin_size;
 
-    /* increment the program size count */
-    ga->size+= ga->bin_size;
+    /* program size counts the addresses written, overlapping code once */
+    ga->size = image->covered;
+    ga->stats.emit_bytes+= ga->bin_size;
 }
 
 #if 0
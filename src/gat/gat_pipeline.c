@@ -0,0 +1,251 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_pipeline.c  pass #1 pipeline. the source is split in chunks of whole 
+    lines; producer threads read and tokenize a chunk each into a bounded 
+    lock-free queue, while the calling thread drains the queues in source order 
+    and scans the lines. messages, symbols and the IR come out exactly as in 
+    serial scanning. */
+#include "gat_pipeline.h"
+#include "gat_core.h"
+#include "gat_str.h"
+#include "gat_parser.h"
+#include "gat_tokenizer.h"
+#include "gat_thread.h"
+#include <stdlib.h>
+
+/* lines a queue holds; power of 2 */
+#define GAT_PIPE_QUEUE_SIZE         1024
+
+/* polls of a full or empty queue before yielding the processor */
+#define GAT_PIPE_SPINS              64
+
+/* a tokenized source line */
+typedef struct _gat_pipe_line {
+    const char *line;           /* trimmed line view */
+    size_t line_len;
+    uint32_t line_num;          /* line number within the chunk */
+    unsigned num_tokens;
+    unsigned status;            /* GAT_TOKENIZE_* errors to report */
+    gat_token tokens [GAT_MAX_TOKENS];
+}gat_pipe_line;
+
+/* single producer, single consumer ring of the lines of a chunk. head and 
+   tail only grow and are kept on separate cache lines. */
+typedef struct _gat_pipe_queue {
+    gat_atomic tail;            /* lines produced */
+    char pad0 [64];
+    gat_atomic head;            /* lines consumed */
+    char pad1 [64];
+    gat_atomic done;            /* chunk is read to the end; num_lines is set */
+    uint32_t num_lines;         /* lines in chunk, blank lines included */
+    const char *begin;          /* chunk of source text */
+    const char *end;
+    gat_atomic *stop;           /* set once the scan needs no more lines */
+    gat_thread thread;
+    gat_pipe_line lines [GAT_PIPE_QUEUE_SIZE];
+}gat_pipe_queue;
+
+/* waits a little for the other end of a queue */
+static void gat_pipe_wait (unsigned *spins) {
+    if (++*spins >= GAT_PIPE_SPINS) {
+        *spins = 0;
+        gat_thread_yield ();
+    }
+}
+
+/* producer; reads and tokenizes non-blank lines of the chunk into the queue */
+static void gat_pipe_produce (void *arg) {
+    gat_pipe_queue *queue = (gat_pipe_queue *)arg;
+    const char *pos = queue->begin;
+    const char *end = queue->end;
+    uint32_t line_num = 0;
+    long head = 0, tail = 0;
+    unsigned spins = 0;
+
+    while (pos < end && !gat_atomic_load (queue->stop)) {
+        const char *view = pos;
+        const char *eol = (const char *)memchr (view, '\n', end - view);
+        gat_pipe_line *line;
+        size_t length;
+
+        if (eol == NULL) {
+            eol = end;
+        }
+        pos = eol + (eol < end ? 1 : 0);
+        ++line_num;
+
+        length = gat_trim_view (&view, eol - view);
+        if (length == 0) {
+            continue;
+        }
+
+        /* wait for a free slot */
+        while (tail - head == GAT_PIPE_QUEUE_SIZE) {
+            head = gat_atomic_load (&queue->head);
+            if (tail - head < GAT_PIPE_QUEUE_SIZE) {
+                break;
+            }
+            if (gat_atomic_load (queue->stop)) {
+                return;
+            }
+            gat_pipe_wait (&spins);
+        }
+
+        line = queue->lines + (tail & (GAT_PIPE_QUEUE_SIZE - 1));
+        line->line = view;
+        line->line_len = length;
+        line->line_num = line_num;
+        line->status = gat_tokenize_text (view, length, line->tokens, &line->num_tokens);
+        gat_atomic_store (&queue->tail, ++tail);
+    }
+
+    queue->num_lines = line_num;
+    gat_atomic_store (&queue->done, 1);
+}
+
+/* consumer; scans lines of the queues in source order until END */
+static void gat_pipe_consume (gat *ga, gat_pipe_queue *queues, unsigned num_queues) {
+    uint32_t base = 0, last = 0;
+    int flag_end = 0;
+    unsigned i;
+
+    for (i = 0; i < num_queues && !flag_end && !ga->fatal_error; i++) {
+        gat_pipe_queue *queue = queues + i;
+        long head = 0, tail = 0;
+        unsigned spins = 0;
+
+        for (;;) {
+            const gat_pipe_line *line;
+            unsigned status;
+
+            /* wait for a line; the chunk ends when its producer is done */
+            if (head == tail) {
+                tail = gat_atomic_load (&queue->tail);
+                if (head == tail) {
+                    if (gat_atomic_load (&queue->done)) {
+                        tail = gat_atomic_load (&queue->tail);
+                        if (head == tail) {
+                            break;
+                        }
+                    } else {
+                        gat_pipe_wait (&spins);
+                    }
+                    continue;
+                }
+            }
+
+            /* load the line as the current line and release its slot */
+            line = queue->lines + (head & (GAT_PIPE_QUEUE_SIZE - 1));
+            ga->line = line->line;
+            ga->line_len = line->line_len;
+            ga->line_num = base + line->line_num;
+            ga->num_tokens = line->num_tokens;
+            memcpy (ga->arr_raw_tokens, line->tokens, line->num_tokens * sizeof(gat_token));
+            status = line->status;
+            gat_atomic_store (&queue->head, ++head);
+
+            ga->stats.lines+= ga->line_num - last;
+            last = ga->line_num;
+
+            gat_tokenize_errors (ga, status);
+            gat_prepare_tokens (ga);
+            if (ga->num_tokens > 0) {
+                gat_scan_line (ga, &flag_end);
+            }
+            if (flag_end || ga->fatal_error) {
+                break;
+            }
+        }
+
+        if (!flag_end) {
+            base+= queue->num_lines;
+        }
+    }
+
+    /* trailing blank lines are read too when there is no END */
+    if (!flag_end) {
+        ga->stats.lines+= base - last;
+    }
+    ga->src_pos = ga->src_size;
+}
+
+/* stops producers still running and waits for them */
+static void gat_pipe_finish (gat_pipe_queue *queues, unsigned num_started, gat_atomic *stop) {
+    unsigned i;
+
+    gat_atomic_store (stop, 1);
+    for (i = 0; i < num_started; i++) {
+        gat_thread_join (&queues[i].thread);
+    }
+    free (queues);
+}
+
+/* scans the source through the pipeline. returns 0 without scanning a line if 
+   the pipeline can't be set up; the source is then scanned serially. */
+int gat_pipe_scan (gat *ga) {
+    const char *src = ga->src;
+    const char *src_end = ga->src + ga->src_size;
+    unsigned num_queues = ga->num_pipe_threads;
+    size_t chunk_size = ga->src_size / num_queues;
+    gat_pipe_queue *queues;
+    gat_atomic stop = 0;
+    jmp_buf outer_jmp;
+    unsigned i;
+
+    queues = (gat_pipe_queue *)calloc (num_queues, sizeof(gat_pipe_queue));
+    if (queues == NULL) {
+        return 0;
+    }
+
+    /* split source in chunks of whole lines and start their producers */
+    for (i = 0; i < num_queues; i++) {
+        gat_pipe_queue *queue = queues + i;
+        const char *end = src_end;
+
+        queue->begin = i == 0 ? src : queues[i - 1].end;
+        if (i + 1 < num_queues && (size_t)(queue->begin - src) < chunk_size * (i + 1)) {
+            const char *split = src + chunk_size * (i + 1);
+            const char *eol = (const char *)memchr (split, '\n', src_end - split);
+            end = eol != NULL ? eol + 1 : src_end;
+        } else if (i + 1 < num_queues) {
+            end = queue->begin;
+        }
+        queue->end = end;
+        queue->stop = &stop;
+
+        if ( !gat_thread_start (&queue->thread, gat_pipe_produce, queue) ) {
+            gat_pipe_finish (queues, i, &stop);
+            return 0;
+        }
+    }
+
+    /* a fatal error stops the producers before it unwinds the engine */
+    memcpy (outer_jmp, ga->fatal_jmp, sizeof(jmp_buf));
+    if (setjmp (ga->fatal_jmp) != 0) {
+        gat_pipe_finish (queues, num_queues, &stop);
+        memcpy (ga->fatal_jmp, outer_jmp, sizeof(jmp_buf));
+        longjmp (ga->fatal_jmp, 1);
+    }
+
+    gat_pipe_consume (ga, queues, num_queues);
+
+    gat_pipe_finish (queues, num_queues, &stop);
+    memcpy (ga->fatal_jmp, outer_jmp, sizeof(jmp_buf));
+    return 1;
+}
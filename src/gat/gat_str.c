@@ -43,89 +43,93 @@ int strcmpi (const char *s1, const char *s2) {
 }
 #endif /* !defined(WIN32) & !defined(DOS) */
 
-/* checks if a character is within array of character ranges */
-int gat_rngcmp ( char ch , const char *strrng ) {
-    unsigned i;
-    char rng[2];
-    for (i = 0 ; i < strlen(strrng) / 2; i++) {
-        rng[0] = strrng [i * 2];
-        rng[1] = strrng [i * 2 + 1];
-        if ( ch >= rng[0] && ch <= rng[1] ) {
-            return 1;
+/* compares a null terminated string with a string view; case insensitive */
+int gat_strcmpi_view (const char *str, const char *text, size_t length) {
+    size_t i;
+    for (i = 0; i < length && str[i]; i++) {
+        int c1 = tolower ((unsigned char)str[i]);
+        int c2 = tolower ((unsigned char)text[i]);
+        if (c1 != c2) {
+            return c1 - c2;
         }
     }
-    return 0;
-}
-
-/* unquotes a string token */
-char *gat_unquote ( const char *strtext, char *buff ) {
-    char *ptr = (char *)strtext;
-    while ( *ptr == '\'' || *ptr == '\"' ) {
-        ptr++;
-    }
-    strcpy (buff, ptr);
-
-    ptr = buff + strlen(buff) - 1;
-    while ( ptr >= buff &&  (*ptr == '\'' || *ptr == '\"') ) {
-        ptr--;
+    if (i < length) {
+        return -1; /* str is shorter */
     }
-    *(++ptr) = '\0';
-    
-    return buff;
+    return str[i] ? 1 : 0;
 }
 
-/* trims string both sides */
-char *gat_trim ( const char *strinput, char *buff ) {   
-    char *ptr = (char *)strinput;
+/* trims a string view both sides and strips off comments without copying. 
+   moves *pstr past leading white space and returns the trimmed length. */
+size_t gat_trim_view (const char **pstr, size_t length) {
+    const char *head = *pstr;
+    const char *tail = head + length;
+    const char *comment;
 
     /* trim left */
-    while ( *ptr && gat_is_white (*ptr) ) {
-        ptr++;
+    while ( head < tail && gat_is_white (*head) ) {
+        ++head;
     }
 
-    /* copy string into buffer */
-    strcpy (buff, ptr);
-
     /* strip off comments */
-    ptr = strchr (buff, GAT_COMMENT_CHAR);
-    if (ptr) {
-        *ptr = '\0';
-    } else {
-        ptr = buff + strlen(buff) - 1;
+    comment = (const char *)memchr (head, GAT_COMMENT_CHAR, tail - head);
+    if (comment) {
+        tail = comment;
     }
 
     /* trim right */
-    while (ptr >= buff && gat_is_white(*ptr)) {
-        --ptr;
+    while ( tail > head && gat_is_white (*(tail - 1)) ) {
+        --tail;
     }
 
-    /* null terminate */
-    *(++ptr) = '\0';
-    return buff;
+    *pstr = head;
+    return tail - head;
 }
 
-/* returns formatted string from variable argument list. The string must 
-   be freed when done. */
-char *gat_format_string (const char *format, va_list arg_list) {
-    size_t size_buff;
-    char *buff;
-    int num_chars_copied;
-    
-    size_buff = 256;
-    buff = (char *)malloc(size_buff * sizeof(char));
-
-    do {
-        num_chars_copied = vsnprintf (buff, size_buff, format, arg_list);
-        if (num_chars_copied == -1) {
-            size_buff*= 2;
-            buff = (char *)realloc (buff, size_buff * sizeof(char));
-            if (buff == NULL) {
-                return NULL;
-            }
-        }
-    } while (num_chars_copied == -1);
+/* case insensitive hash of a keyword view for the perfect hash keyword table. 
+   folding sets bit 5 of every character; a final compare decides the match. */
+uint32_t gat_hash_keyword (uint32_t seed, const char *text, size_t length) {
+    uint32_t hash = seed ^ (uint32_t)length;
+    size_t i;
+    for (i = 0; i < length; i++) {
+        hash = (hash ^ ((uint8_t)text[i] | 0x20)) * 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
 
-    return buff;
+/* 64 bit hash of a byte range for content addressing; reads 8 bytes a step */
+uint64_t gat_hash_bytes (uint64_t seed, const void *data, size_t size) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    const uint8_t *ptr = (const uint8_t *)data;
+    uint64_t hash = seed ^ ((uint64_t)size * prime);
+    uint64_t word;
+
+    for (; size >= 8; ptr+= 8, size-= 8) {
+        memcpy (&word, ptr, 8);
+        hash = (hash ^ word) * prime;
+        hash^= hash >> 29;
+    }
+    word = 0;
+    memcpy (&word, ptr, size);
+    hash = (hash ^ word) * prime;
+    hash^= hash >> 32;
+    return hash;
+}
+
+/* formats variable argument list into buff of size bytes without allocating. 
+   a message that doesn't fit is cut and ends with "...". returns length of 
+   the formatted text. */
+size_t gat_format_buff (char *buff, size_t size, const char *format, va_list arg_list) {
+    int length = vsnprintf (buff, size, format, arg_list);
+
+    if (length < 0 || (size_t)length >= size) {
+        length = (int)size - 1;
+        buff[length] = '\0';
+        if (size > 4) {
+            memcpy (buff + size - 4, "...", 3);
+        }
+    }
+    return (size_t)length;
 }
 
 /* scan for commandline switches */
@@ -18,6 +18,12 @@
  */
 #include "gat_sysutils.h"
 #include "gat_str.h" /* supress C4996 deprecated */
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 /* attaches extension name to path discarding the current extension name */
 char *gat_attach_extension (gat *ga, char *path, const char *ext) {
@@ -28,3 +34,32 @@ char *gat_attach_extension (gat *ga, char *path, const char *ext) {
      strcat (path, ext);
      return path;
 }
+
+/* reads monotonic wall clock and CPU clock of the calling thread in nanoseconds */
+void gat_clock (uint64_t *wall_ns, uint64_t *cpu_ns) {
+#ifdef WIN32
+    LARGE_INTEGER counter, frequency;
+    FILETIME creation, exit, kernel, user;
+    ULARGE_INTEGER k, u;
+
+    QueryPerformanceCounter (&counter);
+    QueryPerformanceFrequency (&frequency);
+    *wall_ns = (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+
+    *cpu_ns = 0;
+    if (GetThreadTimes (GetCurrentThread (), &creation, &exit, &kernel, &user)) {
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        *cpu_ns = (k.QuadPart + u.QuadPart) * 100; /* 100ns units */
+    }
+#else
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    *wall_ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+    *cpu_ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
@@ -21,98 +21,289 @@
 #include "gat_str.h"
 #include "gat_core.h"
 #include "gat_err.h"
+#if defined(__MACH__) || defined(__APPLE__)
+#include <stdlib.h>
+#else
+#include <malloc.h>
+#endif
 
-/* searches for instruction record in the instruction table using binary 
-   search; table is already sorted! */
-int gat_search_instr (gat *ga, const char *strtext) {
-    int start_index, end_index, mid_index, rescmp;    
-    start_index = 0;
-    end_index = ga->len_instr_table - 1;
-    
-    while (end_index >= start_index) {
-        mid_index = start_index + (end_index - start_index) / 2;
-        rescmp = strcmpi (ga->instr_table[mid_index].mnemonic, strtext);
-        if (  rescmp > 0 ) {
-            end_index = mid_index - 1;
-        } else if ( rescmp < 0 ) {
-            start_index = mid_index + 1;
-        } else {
-            return mid_index;
+/* initial capacities; tables double from here */
+#define GAT_SYMTAB_INIT_SLOTS       1024
+#define GAT_SYMTAB_INIT_NAMES       16384
+#define GAT_SYMTAB_INIT_SYMBOLS     256
+
+/* searches for a keyword in the directive and instruction tables. returns 
+   the instruction index, GAT_KW_DIRT | directive index or GAT_KW_NONE. */
+int gat_search_keyword (gat *ga, const char *strtext, size_t length) {
+    const gat_kwtable *kw = ga->kw_table;
+    uint32_t hash;
+    int code;
+    const char *keyword;
+
+    ++ga->stats.kw_lookups;
+    if (kw == NULL) {
+        unsigned i;
+        int start_index, end_index, mid_index, rescmp;
+
+        for (i = 0; i < ga->len_dirt_table; i++) {
+            if (gat_strcmpi_view (ga->dirt_table[i].command, strtext, length) == 0) {
+                return GAT_KW_DIRT | i;
+            }
+        }
+
+        /* binary search; instruction table is already sorted! */
+        start_index = 0;
+        end_index = ga->len_instr_table - 1;
+        while (end_index >= start_index) {
+            mid_index = start_index + (end_index - start_index) / 2;
+            rescmp = gat_strcmpi_view (ga->instr_table[mid_index].mnemonic, strtext, length);
+            if (  rescmp > 0 ) {
+                end_index = mid_index - 1;
+            } else if ( rescmp < 0 ) {
+                start_index = mid_index + 1;
+            } else {
+                return mid_index;
+            }
         }
+        return GAT_KW_NONE; /* not found! */
     }
 
-    /* not found! */
-    return -1;
+    /* one hash picks the slot; one compare confirms the keyword */
+    hash = gat_hash_keyword (kw->seed, strtext, length);
+    code = kw->slots[((hash >> 16) + kw->disp[hash & (kw->num_buckets - 1)]) & (kw->num_slots - 1)];
+    if (code == GAT_KW_NONE) {
+        return GAT_KW_NONE;
+    }
+    keyword = (code & GAT_KW_DIRT) ? ga->dirt_table[code & ~GAT_KW_DIRT].command
+                                   : ga->instr_table[code].mnemonic;
+    return gat_strcmpi_view (keyword, strtext, length) == 0 ? code : GAT_KW_NONE;
 }
 
-/* searches and returns index of id */
-int gat_search_id (gat *ga, const char *id) {
+/* searches for instruction record in the instruction table */
+int gat_search_instr (gat *ga, const char *strtext, size_t length) {
+    int code = gat_search_keyword (ga, strtext, length);
+    if (code == GAT_KW_NONE || (code & GAT_KW_DIRT)) {
+        return -1; /* not found! */
+    }
+    return code;
+}
+
+/* FNV-1a hash of a symbol name */
+static uint32_t gat_sym_hash (const char *name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash^= (uint8_t)*name++;
+        hash*= 16777619u;
+    }
+    return hash;
+}
+
+/* probes for name; returns its slot or the empty slot where it would go */
+static gat_symbol *gat_sym_probe (gat *ga, const char *name, uint32_t hash) {
+    gat_symtab *tab = &ga->symtab;
+    const unsigned mask = tab->num_slots - 1;
+    unsigned i = hash & mask;
+
+    ++ga->stats.sym_lookups;
+    for (;;) {
+        gat_symbol *slot = tab->slots + i;
+        ++ga->stats.sym_probes;
+        if (slot->kind == GAT_SYM_NONE) {
+            return slot;
+        }
+        if (slot->hash == hash && gat_strcmp (tab->names + slot->name, name)) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+/* finds a symbol by name; NULL if not defined */
+static const gat_symbol *gat_sym_find (gat *ga, const char *name) {
+    const gat_symbol *slot;
+    if (ga->symtab.num_symbols == 0) {
+        return NULL;
+    }
+    slot = gat_sym_probe (ga, name, gat_sym_hash (name));
+    return slot->kind == GAT_SYM_NONE ? NULL : slot;
+}
+
+/* doubles the slot array and reinserts all symbols */
+static void gat_sym_rehash (gat *ga) {
+    gat_symtab *tab = &ga->symtab;
+    gat_symbol *old_slots = tab->slots;
+    unsigned old_num_slots = tab->num_slots;
     unsigned i;
-    for (i = 0; i < ga->num_ids; i++) {
-        if ( gat_strcmp (ga->arr_ids[i].name, id) ) {
-            return i; /* found at i */
+
+    tab->num_slots = old_num_slots == 0 ? GAT_SYMTAB_INIT_SLOTS : old_num_slots * 2;
+    tab->slots = (gat_symbol *)calloc (tab->num_slots, sizeof(gat_symbol));
+    if (tab->slots == NULL) {
+        gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+    }
+
+    for (i = 0; i < old_num_slots; i++) {
+        if (old_slots[i].kind != GAT_SYM_NONE) {
+            unsigned j = old_slots[i].hash & (tab->num_slots - 1);
+            while (tab->slots[j].kind != GAT_SYM_NONE) {
+                j = (j + 1) & (tab->num_slots - 1);
+            }
+            tab->slots[j] = old_slots[i];
         }
-    } 
+    }
+    free (old_slots);
+}
+
+/* checks a new symbol name and adds it to the table. returns 0 on error. */
+static int gat_sym_add (gat *ga, const char *name, uint8_t kind, uint32_t index, uint32_t *name_offset) {
+    gat_symtab *tab = &ga->symtab;
+    gat_symbol *slot;
+    uint32_t hash;
+    size_t length, capacity;
+
+    /* keep load factor under 3/4 */
+    if ( (tab->num_symbols + 1) * 4 > tab->num_slots * 3 ) {
+        gat_sym_rehash (ga);
+    }
+
+    hash = gat_sym_hash (name);
+    slot = gat_sym_probe (ga, name, hash);
+    if (slot->kind != GAT_SYM_NONE) {
+        gat_error (ga, GAT_ERR_REDEFINED, "redefinition : %s", name);
+        return 0;
+    }
+
+    length = strlen (name);
+    if (length > GAT_MAX_ID_LEN) {
+        gat_error (ga, GAT_ERR_INVALID_ID, "identifier too long : %s", name);
+        return 0;
+    }
+
+    /* intern the name */
+    capacity = tab->max_names_size;
+    tab->names = (char *)gat_grow (ga, tab->names, sizeof(char), tab->names_size + length + 1, 
+                                   &capacity, GAT_SYMTAB_INIT_NAMES);
+    tab->max_names_size = capacity;
+    memcpy (tab->names + tab->names_size, name, length + 1);
+
+    slot->hash = hash;
+    slot->name = (uint32_t)tab->names_size;
+    slot->index = index;
+    slot->kind = kind;
+
+    tab->names_size+= length + 1;
+    ++tab->num_symbols;
+
+    *name_offset = slot->name;
+    return 1;
+}
+
+void gat_symtab_init (gat *ga) {
+    memset (&ga->symtab, 0, sizeof(gat_symtab));
+    ga->num_ids = 0;
+    ga->max_ids = 0;
+    ga->arr_ids = NULL;
+    ga->num_labels = 0;
+    ga->max_labels = 0;
+    ga->arr_labels = NULL;
+}
+
+/* removes all symbols keeping allocated memory */
+void gat_symtab_reset (gat *ga) {
+    gat_symtab *tab = &ga->symtab;
+    if (tab->slots != NULL) {
+        memset (tab->slots, 0, tab->num_slots * sizeof(gat_symbol));
+    }
+    tab->num_symbols = 0;
+    tab->names_size = 0;
+    ga->num_ids = 0;
+    ga->num_labels = 0;
+}
+
+void gat_symtab_free (gat *ga) {
+    free (ga->symtab.slots);
+    free (ga->symtab.names);
+    free (ga->arr_ids);
+    free (ga->arr_labels);
+    gat_symtab_init (ga);
+}
+
+/* searches and returns index of id */
+int gat_search_id (gat *ga, const char *id) {
+    const gat_symbol *sym = gat_sym_find (ga, id);
+    if (sym != NULL && sym->kind == GAT_SYM_ID) {
+        return (int)sym->index; /* found */
+    }
     return -1; /* id not found */
 }
 
 /* defines a new id */
 int gat_define_id (gat *ga, const char *id, uint16_t data, uint8_t id_type) {   
-    int flag_dup  = 0;
+    gat_id *new_id;
+    size_t capacity;
+    uint32_t name;
 
-    /* search for exsiting id */
-    if ( (gat_search_id (ga, id) != -1) || (gat_search_label (ga, id) != -1) ) {
-        flag_dup = 1;
+    /* one probe checks both ids and labels for redefinition */
+    if ( !gat_sym_add (ga, id, GAT_SYM_ID, ga->num_ids, &name) ) {
+        return 0; /* error defining id! */
     }
 
-    if (flag_dup) {
-        gat_error (ga, GAT_ERR_REDEFINED, "redefinition : %s", id);
-    } else if (ga->num_ids == GAT_MAX_IDS) {
-        gat_error (ga, GAT_ERR_TOO_MANY_IDS, "too many ids");
-    } else if (strlen(id) > GAT_MAX_ID_LEN) {
-        gat_error (ga, GAT_ERR_INVALID_ID, "identifier too long : %s", id);
-    } else {
-        strcpy (ga->arr_ids[ga->num_ids].name, id);
-        ga->arr_ids[ga->num_ids].idtype = id_type;
-        ga->arr_ids[ga->num_ids++].data = data;
-        return 1; /* new id defined */
+    capacity = ga->max_ids;
+    ga->arr_ids = (gat_id *)gat_grow (ga, ga->arr_ids, sizeof(gat_id), ga->num_ids + 1, 
+                                      &capacity, GAT_SYMTAB_INIT_SYMBOLS);
+    ga->max_ids = (unsigned)capacity;
+
+    new_id = ga->arr_ids + ga->num_ids++;
+    new_id->name = name;
+    new_id->idtype = id_type;
+    new_id->data = data;
+    return 1; /* new id defined */
+}
+
+/* searches and returns index of macro */
+int gat_search_macro (gat *ga, const char *id) {
+    const gat_symbol *sym = gat_sym_find (ga, id);
+    if (sym != NULL && sym->kind == GAT_SYM_MACRO) {
+        return (int)sym->index; /* found */
     }
+    return -1; /* macro not found */
+}
+
+/* defines a new macro name for arr_macros at index */
+int gat_define_macro (gat *ga, const char *id, unsigned index) {
+    uint32_t name;
 
-    return 0; /* error defining id! */
+    /* macros share one namespace with ids and labels */
+    return gat_sym_add (ga, id, GAT_SYM_MACRO, index, &name);
 }
 
 /* searches and returns index of label */
 int gat_search_label (gat *ga, const char *id) {
-    unsigned i;
-    for (i = 0; i < ga->num_labels; i++) {
-        if ( gat_strcmp (ga->arr_labels[i].name, id) ) {
-            return i; /* found at i */
-        }
+    const gat_symbol *sym = gat_sym_find (ga, id);
+    if (sym != NULL && sym->kind == GAT_SYM_LABEL) {
+        return (int)sym->index; /* found */
     }
     return -1; /* label not found! */
 }
 
 /* defines a new label */
 int gat_define_label (gat *ga, const char *id, uint16_t address) {
-    int flag_dup = 0;
+    gat_label *new_label;
+    size_t capacity;
+    uint32_t name;
 
-    /* search for exsiting label */
-    if ( (gat_search_label(ga, id) != -1) || (gat_search_id(ga, id) != -1) ) {
-        flag_dup = 1;
+    /* one probe checks both labels and ids for redefinition */
+    if ( !gat_sym_add (ga, id, GAT_SYM_LABEL, ga->num_labels, &name) ) {
+        return 0; /* error defining label! */
     }
 
-    if (flag_dup) {
-        gat_error (ga, GAT_ERR_REDEFINED, "redefinition : %s", id);
-    } else if (ga->num_labels == GAT_MAX_LABELS)
-        gat_error (ga, GAT_ERR_TOO_MANY_IDS, "too many labels");    
-    else if (strlen(id) > GAT_MAX_ID_LEN) {
-        gat_error (ga, GAT_ERR_INVALID_ID, "identifier too long : %d", id);
-    } else {
-        /* add new label to label list */
-        strcpy (ga->arr_labels [ga->num_labels].name, id);
-        ga->arr_labels [ga->num_labels++].address = address;        
-        return 1; /* new label defined */
-    }
+    capacity = ga->max_labels;
+    ga->arr_labels = (gat_label *)gat_grow (ga, ga->arr_labels, sizeof(gat_label), ga->num_labels + 1, 
+                                            &capacity, GAT_SYMTAB_INIT_SYMBOLS);
+    ga->max_labels = (unsigned)capacity;
 
-    return 0; /* error defining label! */
+    /* add new label to label list */
+    new_label = ga->arr_labels + ga->num_labels++;
+    new_label->name = name;
+    new_label->address = address;
+    return 1; /* new label defined */
 }
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** gat_thread.c  thread primitives used by the parallel engine stages. */
+#include "gat_thread.h"
+#ifndef WIN32
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#ifdef WIN32
+static DWORD WINAPI gat_thread_main (LPVOID param) {
+    gat_thread *thread = (gat_thread *)param;
+    thread->run (thread->arg);
+    return 0;
+}
+#else
+static void *gat_thread_main (void *param) {
+    gat_thread *thread = (gat_thread *)param;
+    thread->run (thread->arg);
+    return NULL;
+}
+#endif
+
+/* starts a thread running run(arg); returns 0 if the thread can't be started. 
+   thread must stay in place until joined. */
+int gat_thread_start (gat_thread *thread, void (* run) (void *), void *arg) {
+    thread->run = run;
+    thread->arg = arg;
+#ifdef WIN32
+    thread->handle = CreateThread (NULL, 0, gat_thread_main, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    return pthread_create (&thread->handle, NULL, gat_thread_main, thread) == 0;
+#endif
+}
+
+/* waits for a started thread to finish */
+void gat_thread_join (gat_thread *thread) {
+#ifdef WIN32
+    WaitForSingleObject (thread->handle, INFINITE);
+    CloseHandle (thread->handle);
+#else
+    pthread_join (thread->handle, NULL);
+#endif
+}
+
+/* gives up the rest of the time slice while waiting on another thread */
+void gat_thread_yield (void) {
+#ifdef WIN32
+    SwitchToThread ();
+#else
+    sched_yield ();
+#endif
+}
+
+void gat_mutex_lock (gat_mutex *mutex) {
+#ifdef WIN32
+    AcquireSRWLockExclusive (mutex);
+#else
+    pthread_mutex_lock (mutex);
+#endif
+}
+
+void gat_mutex_unlock (gat_mutex *mutex) {
+#ifdef WIN32
+    ReleaseSRWLockExclusive (mutex);
+#else
+    pthread_mutex_unlock (mutex);
+#endif
+}
+
+/* returns number of processors available */
+unsigned gat_num_processors (void) {
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo (&info);
+    return (unsigned)info.dwNumberOfProcessors;
+#else
+    long count = sysconf (_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (unsigned)count : 1;
+#endif
+}
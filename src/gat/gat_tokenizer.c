@@ -18,7 +18,9 @@
  */
 #include "gat_tokenizer.h"
 #include "gat_core.h"
+#include "gat_str.h"
 #include "gat_err.h"
+#include "gat_conv.h"
 #include <malloc.h>
 
 /* disable warnings */
@@ -32,9 +34,29 @@ int gat_is_whitespace_token (const gat_token *token) {
     return token->length == 0 && token->string[0] != _tx('\'');
 }
 
-unsigned gat_tokenize_line (gat *ga) {
-    unsigned int i;
+/* checks if token text equals a string; case insensitive */
+int gat_token_equi (const gat_token *token, const char *str) {
+    return gat_strcmpi_view (str, token->string, token->length) == 0;
+}
+
+/* returns null terminated text of a token. text is copied in the token's text 
+   buffer on first use; tokens are only slices of the source line. */
+const char *gat_token_cstr (gat *ga, unsigned index) {
+    const gat_token *token = &ga->arr_raw_tokens[index];
+    char *text = ga->arr_token_text[index];
+    size_t length = token->length;
+
+    if (length > GAT_MAX_LINEBUFF_SIZE) {
+        length = GAT_MAX_LINEBUFF_SIZE;
+    }
+    memcpy (text, token->string, sizeof(char) * length);
+    text[length] = '\0';
+
+    ga->arr_tokens[index] = text;
+    return text;
+}
 
+unsigned gat_tokenize_line (gat *ga) {
     /* reset token counter and mark the start of the token */   
     gat_tokenize (ga);
 
@@ -44,16 +66,51 @@ unsigned gat_tokenize_line (gat *ga) {
     }
 #endif
 
-    /* set token strings */
+    gat_prepare_tokens (ga);
+    return ga->num_tokens;
+}
+
+/* prepares raw tokens of the current line for parsing */
+void gat_prepare_tokens (gat *ga) {
+    unsigned int i;
+
+    /* token strings are made on demand */
     for (i = 0; i < ga->num_tokens; i++) {
-        ga->arr_tokens[i] = ga->arr_raw_tokens[i].string;
+        ga->arr_tokens[i] = NULL;
+        ga->arr_token_class[i] = GAT_OPCLASS_NONE;
     }
+    ga->stats.tokens+= ga->num_tokens;
+}
 
-    return ga->num_tokens;
+/* reports errors of the GAT_TOKENIZE_* status of a line */
+void gat_tokenize_errors (gat *ga, unsigned status) {
+    if (status & GAT_TOKENIZE_TOO_MANY) {
+        gat_error (ga, GAT_ERR_TOO_MANY_TOKENS, "too many tokens");
+    }
+    if (status & GAT_TOKENIZE_OPEN_QUOTE) {
+        gat_error (ga, 1, "unterminated string");
+    }
 }
 
 size_t gat_tokenize (gat *ga) {
-    char *head, *tail;
+    unsigned num_tokens;
+    unsigned status = gat_tokenize_text (ga->line, ga->line_len, ga->arr_raw_tokens, 
+                                         &num_tokens);
+
+    ga->num_tokens = num_tokens;
+    gat_tokenize_errors (ga, status);
+
+    /* return number of tokens parsed */
+    return (status & GAT_TOKENIZE_OPEN_QUOTE) ? (size_t)-1 : num_tokens;
+}
+
+/* splits a line into at most GAT_MAX_TOKENS tokens; a line with more gives 
+   no tokens, so that it is reported once and not scanned in part. touches no 
+   assembler state so lines can be tokenized on any thread; errors are returned 
+   as GAT_TOKENIZE_* status flags for the caller to report. */
+unsigned gat_tokenize_text (const char *line, size_t line_len, gat_token *tokens, 
+                            unsigned *num_tokens) {
+    const char *head, *tail, *end;
     int flag_sym;
     int flag_white;
     int flag_quote;
@@ -62,32 +119,33 @@ size_t gat_tokenize (gat *ga) {
     
     gat_token *token;
     const size_t max_tokens = GAT_MAX_TOKENS;
+    unsigned status = 0;
 
-    ga->num_tokens = 0;
-    token = ga->arr_raw_tokens;
+    *num_tokens = 0;
+    token = tokens;
 
     /* init vars */
     flag_sym = 0;
     flag_quote = 0;
     quote_char = '\"';
 
-    head = ga->str_line;
+    head = line;
+    end = line + line_len;
 
     while (1) {
         /* skip white space */
-        while ( *head &&  gat_is_white(*head) ) {
+        while ( head < end &&  gat_is_white(*head) ) {
             ++head;
         }
 
         /* passed the line? */  
-        if ( *head == _tx('\0') ) {
-            ++head;
+        if ( head >= end ) {
             break;
         }
 
         /* check for token limit */
-        if (ga->num_tokens == max_tokens ) {
-            gat_error (ga, GAT_ERR_TOO_MANY_TOKENS, "too many tokens");
+        if (*num_tokens == max_tokens ) {
+            status|= GAT_TOKENIZE_TOO_MANY;
             break;
         }
 
@@ -112,8 +170,13 @@ size_t gat_tokenize (gat *ga) {
             token_type = GAT_TOK_WORD;
         }
 
+        /* words end at the first delimiter; skip to it in one scan */
+        if (token_type == GAT_TOK_WORD) {
+            tail = gat_scan_delim (tail, end);
+        }
+
         /* find the end of token */
-        while (*tail) {
+        while (tail < end) {
             /* get the character in buffer */
             ch = *tail;
 
@@ -149,7 +212,7 @@ size_t gat_tokenize (gat *ga) {
             ++tail; /* point to next character */
         } /* !flag_quote */
         
-        /* add the token */
+        /* add the token; token is a slice of the line */
         {
             /* unquote string token if required */
             size_t length = tail - head;
@@ -157,24 +220,20 @@ size_t gat_tokenize (gat *ga) {
                 ++head;
                 length-= 2;
             }
-            /* free existing token if required */
-            if (token->string && token->length < length) {
-                free (token->string);
-                token->string = NULL;
-            }
-            /* allocate new token memory only if required */
-            if (!token->string) {
-                token->string = (char *)malloc (sizeof(char) * (length + 1));
-            }
-            memcpy (token->string, head, sizeof(char) * length);
-            token->string [length] = '\0';
-            /* strcpy (token->string, head); */
+            token->string = head;
             token->length = length;
             token->type = token_type;
+
+            /* decode numbers once; parser reads the cached value */
+            token->num_value = 0;
+            token->num_width = GAT_NUMW_NONE;
+            if ( gat_decode_num (head, length, &token->num_value) ) {
+                token->num_width = gat_num_width (token->num_value);
+            }
         }
 
         /* increment the token counter */
-        ++ga->num_tokens;
+        ++*num_tokens;
 
         ++token;
     
@@ -182,27 +241,31 @@ size_t gat_tokenize (gat *ga) {
         head = tail;
     }
 
+    /* drop a truncated line */
+    if (status & GAT_TOKENIZE_TOO_MANY) {
+        *num_tokens = 0;
+    }
+
     /* check if string quote is open */
     if (flag_quote) {
-        gat_error (ga, 1, "unterminated string");
-        return -1;
+        status|= GAT_TOKENIZE_OPEN_QUOTE;
     }
 
-    /* return number of tokens parsed */
-    return ga->num_tokens;
+    return status;
 }
 
-/* free all raw tokens. note that this does not reset the token strings */
+/* clears all raw tokens and token strings. tokens don't own any memory. */
 void gat_free_tokens (gat *ga) {
     int i;
     for (i = 0; i < GAT_MAX_TOKENS; i++) {
-        if (ga->arr_raw_tokens[i].string != NULL) {
-            free (ga->arr_raw_tokens[i].string);
-            ga->arr_raw_tokens[i].string = NULL;
-            ga->arr_raw_tokens[i].length = 0;
-            ga->arr_raw_tokens[i].type = GAT_TOK_INVALID;
-        }
+        ga->arr_raw_tokens[i].string = NULL;
+        ga->arr_raw_tokens[i].length = 0;
+        ga->arr_raw_tokens[i].type = GAT_TOK_INVALID;
+        ga->arr_raw_tokens[i].num_value = 0;
+        ga->arr_raw_tokens[i].num_width = GAT_NUMW_NONE;
+        ga->arr_tokens[i] = NULL;
     }
+    ga->num_tokens = 0;
 }
 
 #if _DEBUG
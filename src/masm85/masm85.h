@@ -0,0 +1,111 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** masm85.h  declarations shared by masm85 front-end modules. */
+#ifndef __masm85_h__
+#define __masm85_h__
+
+#include "gat.h"
+
+/* define extern "C" { for C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MASM85_VERSION                  "0.0.1"
+
+/* command line switch flags */
+#define MASM85_SWITCH_HEX               1
+#define MASM85_SWITCH_85                2
+#define MASM85_SWITCH_O                 4
+#define MASM85_SWITCH_DBG               8
+#define MASM85_SWITCH_HELP              16
+#define MASM85_SWITCH_REC               32
+#define MASM85_SWITCH_J                 64
+#define MASM85_SWITCH_SINGLE            128
+#define MASM85_SWITCH_CACHE             256
+#define MASM85_SWITCH_CLIMIT            512
+#define MASM85_SWITCH_STATS             1024
+#define MASM85_SWITCH_MAXERR            2048
+#define MASM85_SWITCH_PIPE              4096
+#define MASM85_SWITCH_MT                8192
+
+/* stats report formats */
+#define MASM85_STATS_NONE               0
+#define MASM85_STATS_TEXT               1
+#define MASM85_STATS_JSON               2
+
+/* result of assembling a batch input */
+typedef struct _masm85_result {
+    int exit_code;              /* exit code of the engine */
+    int fatal_error;            /* fatal error number; 0 if none */
+    unsigned err_count;
+    unsigned warn_count;
+    int cache_hit;              /* 1 if restored from cache, 0 on miss, -1 without cache */
+    gat_stats stats;
+}masm85_result;
+
+/* totals of a batch */
+typedef struct _masm85_totals {
+    int exit_code;
+    unsigned num_failed;
+    unsigned err_count;
+    unsigned warn_count;
+    unsigned cache_hits;
+    unsigned cache_misses;
+    gat_stats stats;
+}masm85_totals;
+
+/* masm85_lib.c */
+void masm85_init (gat *ga);
+
+/* masm85_main.c */
+void masm85_assemble_input (gat *ga, unsigned index, masm85_result *result);
+void masm85_add_result (masm85_totals *totals, const masm85_result *result);
+
+/* masm85_cmdline.c */
+unsigned masm85_process_commandline (gat *ga, int argc, char *argv[]);
+void masm85_attach_source (gat *ga, unsigned index);
+unsigned masm85_get_jobs (void);
+int masm85_get_stats (void);
+void masm85_free_commandline (void);
+
+/* masm85_callbacks.c */
+void masm85_callback (gat *ga, gat_callback_type type, void *data, void *context);
+void *masm85_log_create (void);
+void masm85_log_flush (void *context, FILE *fp);
+void masm85_log_free (void *context);
+
+/* masm85_jobs.c */
+void masm85_run_jobs (gat *ga, unsigned num_inputs, unsigned num_jobs, masm85_totals *totals);
+
+/* masm85_stats.c */
+void masm85_print_stats (gat *ga, const masm85_totals *totals, unsigned num_inputs, 
+                         uint64_t wall_ns, int format);
+
+/* masm85_cache.c */
+void masm85_cache_enable (const char *dir, unsigned long max_size);
+int masm85_cache_restore (gat *ga, uint64_t *key);
+int masm85_cache_store (gat *ga, uint64_t key);
+unsigned masm85_cache_evict (void);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* !__masm85_h__ */
@@ -86,7 +86,7 @@ static void masm85_get_code_size (gat *ga, const gat_instr *instr) {
         /* test token with operand and update g_bin_size */
         switch (options) {
         case GAT_OPRND_BYTE:
-            if (options == 0) /* immediate value? */ {
+            if (instr->type_options[i] == 0) /* immediate value? */ {
                 ++ga->bin_size; /* add byte to opcode */
             }
             break;
@@ -137,7 +137,7 @@ static void masm85_gen_code (gat *ga, const gat_instr *instr) {
 }
 
 /* masm85 arch interface */
-gat_arch masm85_arch = {
+const gat_arch masm85_arch = {
     masm85_is_reg8,
     masm85_is_reg16,
     NULL,
@@ -0,0 +1,409 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** masm85_cache.c  content-hash build cache of masm85 outputs. 
+
+    An entry is keyed by a hash of the source bytes, the switches that shape 
+    the outputs and the assembler version. It holds all outputs of the source 
+    and is restored in place of running the engine. Entries are evicted least 
+    recently used first once the cache grows past its size limit. */
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <direct.h>     /* _mkdir() */
+#include <process.h>    /* _getpid() */
+#include <sys/utime.h>
+#define getpid          _getpid
+#define mkdir(_p, _m)   _mkdir(_p)
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+#include "masm85.h"
+
+/* entry file format; bumped whenever output files change so older entries miss */
+#define MASM85_CACHE_MAGIC          0x4338354Dul    /* "M85C" */
+#define MASM85_CACHE_FORMAT         2
+#define MASM85_CACHE_EXT            ".m85c"
+
+/* size of entry paths; cache directory is limited to GAT_MAX_PATH */
+#define MASM85_CACHE_PATH_SIZE      (GAT_MAX_PATH + 64)
+
+/* size of the buffer outputs are copied through */
+#define MASM85_CACHE_COPY_SIZE      (64 * 1024)
+
+/* entry file header; followed by each output as a uint32_t length and bytes */
+typedef struct _masm85_cache_header {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t key_lo;
+    uint32_t key_hi;
+    uint32_t code_size;         /* ga->size of the assembled source */
+    uint32_t num_outputs;
+}masm85_cache_header;
+
+/* entry found in the cache directory */
+typedef struct _masm85_cache_entry {
+    char name [32];
+    unsigned long size;
+    time_t mtime;
+}masm85_cache_entry;
+
+/* cache settings; set from the command line before any input is assembled */
+static int s_cache_enabled = 0;
+static char s_cache_dir [GAT_MAX_PATH];
+static unsigned long s_cache_limit = 0;
+
+/* enables the cache in dir; entries are evicted beyond max_size bytes */
+void masm85_cache_enable (const char *dir, unsigned long max_size) {
+    size_t length;
+
+    strncpy (s_cache_dir, dir, GAT_MAX_PATH - 1);
+    s_cache_dir[GAT_MAX_PATH - 1] = '\0';
+    length = strlen (s_cache_dir);
+    /* strip trailing separators */
+    while (length > 1 && (s_cache_dir[length - 1] == '/' || s_cache_dir[length - 1] == '\\')) {
+        s_cache_dir[--length] = '\0';
+    }
+    s_cache_limit = max_size;
+    s_cache_enabled = 1;
+}
+
+/* formats a path into buff of size bytes; returns 0 if it doesn't fit. 
+   vsnprintf as older C libraries lack snprintf. */
+static int masm85_cache_format (char *buff, size_t size, const char *format, ...) {
+    va_list arg_list;
+    int length;
+
+    va_start (arg_list, format);
+    length = vsnprintf (buff, size, format, arg_list);
+    va_end (arg_list);
+    return length >= 0 && (size_t)length < size;
+}
+
+/* makes path of the entry for key; returns 0 if it is too long */
+static int masm85_cache_path (char *path, uint64_t key, const char *ext) {
+    return masm85_cache_format (path, MASM85_CACHE_PATH_SIZE, "%s/%08lx%08lx%s", s_cache_dir, 
+                                (unsigned long)(key >> 32), 
+                                (unsigned long)(key & 0xFFFFFFFFul), ext);
+}
+
+/* hashes the source and the switches shaping the outputs. the source is 
+   loaded for the engine and hashed in place, 8 bytes a step. */
+static int masm85_cache_key (gat *ga, uint64_t *key) {
+    uint32_t options[3];
+
+    if (!gat_preload_source (ga)) {
+        return 0;
+    }
+
+    options[0] = (uint32_t)(ga->cmdline_flags & 
+                            (MASM85_SWITCH_HEX | MASM85_SWITCH_85 | MASM85_SWITCH_DBG));
+    options[1] = ga->max_rec_length;
+    options[2] = MASM85_CACHE_FORMAT;
+
+    *key = gat_hash_bytes (0, MASM85_VERSION GAT_VERSION, sizeof(MASM85_VERSION GAT_VERSION));
+    *key = gat_hash_bytes (*key, options, sizeof(options));
+    *key = gat_hash_bytes (*key, ga->src, ga->src_size);
+    return 1;
+}
+
+/* copies length bytes from one stream to the other */
+static int masm85_cache_copy (FILE *from, FILE *to, unsigned long length, char *buff) {
+    while (length > 0) {
+        size_t count = length < MASM85_CACHE_COPY_SIZE ? length : MASM85_CACHE_COPY_SIZE;
+        if ( fread (buff, 1, count, from) != count || fwrite (buff, 1, count, to) != count ) {
+            return 0;
+        }
+        length-= (unsigned long)count;
+    }
+    return 1;
+}
+
+/* restores outputs of the attached source from the cache. returns 1 on a hit, 
+   0 on a miss with the key of the source in key and -1 when the cache is not 
+   enabled or the source can't be read. */
+int masm85_cache_restore (gat *ga, uint64_t *key) {
+    char path [MASM85_CACHE_PATH_SIZE];
+    masm85_cache_header header;
+    char *buff;
+    FILE *fp;
+    unsigned i;
+    int hit;
+
+    if (!s_cache_enabled) {
+        return -1;
+    }
+    if (!masm85_cache_key (ga, key)) {
+        return -1; /* the engine reports the input error */
+    }
+
+    if (!masm85_cache_path (path, *key, MASM85_CACHE_EXT)) {
+        return -1;
+    }
+    fp = fopen (path, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    if ( fread (&header, sizeof(header), 1, fp) != 1 || 
+         header.magic != MASM85_CACHE_MAGIC || header.format != MASM85_CACHE_FORMAT || 
+         header.key_lo != (uint32_t)(*key & 0xFFFFFFFFul) || 
+         header.key_hi != (uint32_t)(*key >> 32) || 
+         header.num_outputs != ga->num_ios - 1 ) {
+        fclose (fp);
+        return 0;
+    }
+
+    buff = (char *)malloc (MASM85_CACHE_COPY_SIZE);
+    hit = (buff != NULL);
+    for (i = 1; i < ga->num_ios && hit; i++) {
+        uint32_t length;
+        FILE *out;
+
+        if (fread (&length, sizeof(length), 1, fp) != 1) {
+            hit = 0;
+            break;
+        }
+        out = fopen (ga->ios[i].path, "wb");
+        if (out == NULL) {
+            hit = 0;
+            break;
+        }
+        hit = masm85_cache_copy (fp, out, length, buff);
+        if (fclose (out) != 0) {
+            hit = 0;
+        }
+    }
+    free (buff);
+    fclose (fp);
+
+    if (!hit) {
+        return 0; /* the engine rewrites the outputs */
+    }
+
+    /* recently used entries are evicted last */
+    utime (path, NULL);
+
+    ga->size = header.code_size;
+    gat_print (ga, "restoring %s from cache", ga->ios[0].path);
+    gat_print (ga, "written %u bytes to %s", ga->size, ga->ios[1].path);
+    gat_print (ga, "%u error(s) %u warning(s)", ga->err_count, ga->warn_count);
+    return 1;
+}
+
+/* stores outputs of the source assembled without errors under key */
+int masm85_cache_store (gat *ga, uint64_t key) {
+    char path [MASM85_CACHE_PATH_SIZE];
+    char temp_path [MASM85_CACHE_PATH_SIZE + 40];
+    masm85_cache_header header;
+    char *buff;
+    FILE *fp;
+    unsigned i;
+    int stored;
+
+    if (!s_cache_enabled) {
+        return 0;
+    }
+    mkdir (s_cache_dir, 0777); /* may exist */
+
+    /* entry is written under a name private to the writer and renamed in place */
+    if ( !masm85_cache_path (path, key, MASM85_CACHE_EXT) || 
+         !masm85_cache_format (temp_path, sizeof(temp_path), "%s.%lx.%lx", path, 
+                               (unsigned long)getpid (), (unsigned long)(size_t)ga) ) {
+        return 0;
+    }
+    fp = fopen (temp_path, "wb");
+    if (fp == NULL) {
+        return 0;
+    }
+
+    header.magic = MASM85_CACHE_MAGIC;
+    header.format = MASM85_CACHE_FORMAT;
+    header.key_lo = (uint32_t)(key & 0xFFFFFFFFul);
+    header.key_hi = (uint32_t)(key >> 32);
+    header.code_size = ga->size;
+    header.num_outputs = ga->num_ios - 1;
+
+    buff = (char *)malloc (MASM85_CACHE_COPY_SIZE);
+    stored = (buff != NULL) && (fwrite (&header, sizeof(header), 1, fp) == 1);
+    for (i = 1; i < ga->num_ios && stored; i++) {
+        FILE *out = fopen (ga->ios[i].path, "rb");
+        uint32_t length;
+        long size;
+
+        if (out == NULL) {
+            stored = 0;
+            break;
+        }
+        if ( fseek (out, 0, SEEK_END) != 0 || (size = ftell (out)) < 0 || 
+             fseek (out, 0, SEEK_SET) != 0 ) {
+            fclose (out);
+            stored = 0;
+            break;
+        }
+        length = (uint32_t)size;
+        stored = fwrite (&length, sizeof(length), 1, fp) == 1 && 
+                 masm85_cache_copy (out, fp, length, buff);
+        fclose (out);
+    }
+    free (buff);
+    if (fclose (fp) != 0) {
+        stored = 0;
+    }
+
+    if (stored) {
+#ifdef WIN32
+        remove (path);
+#endif
+        stored = (rename (temp_path, path) == 0);
+    }
+    if (!stored) {
+        remove (temp_path);
+    }
+    return stored;
+}
+
+/* orders entries least recently used first */
+static int masm85_cache_compare (const void *a, const void *b) {
+    const masm85_cache_entry *ea = (const masm85_cache_entry *)a;
+    const masm85_cache_entry *eb = (const masm85_cache_entry *)b;
+    return ea->mtime < eb->mtime ? -1 : (ea->mtime > eb->mtime ? 1 : 0);
+}
+
+/* adds an entry to the list */
+static int masm85_cache_add_entry (masm85_cache_entry **entries, unsigned *num_entries, 
+                                   unsigned *max_entries, const char *name, 
+                                   unsigned long size, time_t mtime) {
+    masm85_cache_entry *entry;
+
+    if (strlen (name) >= sizeof(entry->name)) {
+        return 1; /* not an entry */
+    }
+    if (*num_entries == *max_entries) {
+        unsigned capacity = *max_entries == 0 ? 256 : *max_entries * 2;
+        masm85_cache_entry *temp = (masm85_cache_entry *)realloc (*entries, 
+                                        capacity * sizeof(masm85_cache_entry));
+        if (temp == NULL) {
+            return 0;
+        }
+        *entries = temp;
+        *max_entries = capacity;
+    }
+    entry = *entries + (*num_entries)++;
+    strcpy (entry->name, name);
+    entry->size = size;
+    entry->mtime = mtime;
+    return 1;
+}
+
+/* lists entries of the cache directory */
+static unsigned masm85_cache_list (masm85_cache_entry **entries) {
+    unsigned num_entries = 0, max_entries = 0;
+    const size_t ext_length = strlen (MASM85_CACHE_EXT);
+#ifdef WIN32
+    char pattern [MASM85_CACHE_PATH_SIZE];
+    WIN32_FIND_DATAA data;
+    HANDLE hfind;
+
+    if (!masm85_cache_format (pattern, sizeof(pattern), "%s/*%s", s_cache_dir, MASM85_CACHE_EXT)) {
+        return 0;
+    }
+    hfind = FindFirstFileA (pattern, &data);
+    if (hfind == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    do {
+        ULARGE_INTEGER mtime;
+        size_t length = strlen (data.cFileName);
+        if ( length <= ext_length || 
+             strcmp (data.cFileName + length - ext_length, MASM85_CACHE_EXT) != 0 ) {
+            continue;
+        }
+        mtime.LowPart = data.ftLastWriteTime.dwLowDateTime;
+        mtime.HighPart = data.ftLastWriteTime.dwHighDateTime;
+        if ( !masm85_cache_add_entry (entries, &num_entries, &max_entries, data.cFileName, 
+                                      data.nFileSizeLow, (time_t)(mtime.QuadPart / 10000000)) ) {
+            break;
+        }
+    } while (FindNextFileA (hfind, &data));
+    FindClose (hfind);
+#else
+    char path [MASM85_CACHE_PATH_SIZE];
+    struct dirent *ent;
+    struct stat st;
+    DIR *dir = opendir (s_cache_dir);
+
+    if (dir == NULL) {
+        return 0;
+    }
+    while ((ent = readdir (dir)) != NULL) {
+        size_t length = strlen (ent->d_name);
+        if ( length <= ext_length || 
+             strcmp (ent->d_name + length - ext_length, MASM85_CACHE_EXT) != 0 ) {
+            continue;
+        }
+        if ( !masm85_cache_format (path, sizeof(path), "%s/%s", s_cache_dir, ent->d_name) || 
+             stat (path, &st) != 0 ) {
+            continue;
+        }
+        if ( !masm85_cache_add_entry (entries, &num_entries, &max_entries, ent->d_name, 
+                                      (unsigned long)st.st_size, st.st_mtime) ) {
+            break;
+        }
+    }
+    closedir (dir);
+#endif
+    return num_entries;
+}
+
+/* evicts least recently used entries until the cache fits its size limit. 
+   returns number of entries evicted. */
+unsigned masm85_cache_evict (void) {
+    masm85_cache_entry *entries = NULL;
+    unsigned long total = 0;
+    unsigned num_entries, num_evicted = 0, i;
+
+    if (!s_cache_enabled) {
+        return 0;
+    }
+
+    num_entries = masm85_cache_list (&entries);
+    for (i = 0; i < num_entries; i++) {
+        total+= entries[i].size;
+    }
+    if (total > s_cache_limit) {
+        qsort (entries, num_entries, sizeof(masm85_cache_entry), masm85_cache_compare);
+        for (i = 0; i < num_entries && total > s_cache_limit; i++) {
+            char path [MASM85_CACHE_PATH_SIZE];
+            if ( masm85_cache_format (path, sizeof(path), "%s/%s", s_cache_dir, entries[i].name) && 
+                 remove (path) == 0 ) {
+                total-= entries[i].size;
+                ++num_evicted;
+            }
+        }
+    }
+    free (entries);
+    return num_evicted;
+}
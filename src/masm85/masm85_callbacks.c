@@ -16,31 +16,88 @@
  * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include "gat.h"
+#include "masm85.h"
+#include <stdlib.h>
 
 #define MASM85_PRINT_TEXT_MESSAGE
 
+/* message log of a batch job. -j workers log messages of a source here so 
+   the batch can be reported in input order. */
+typedef struct _masm85_log {
+    char *text;
+    size_t length;
+    size_t capacity;
+}masm85_log;
+
+/* creates an empty message log */
+void *masm85_log_create (void) {
+    return calloc (1, sizeof(masm85_log));
+}
+
+/* writes the logged messages to the stream and empties the log */
+void masm85_log_flush (void *context, FILE *fp) {
+    masm85_log *log = (masm85_log *)context;
+    fwrite (log->text, 1, log->length, fp);
+    log->length = 0;
+}
+
+void masm85_log_free (void *context) {
+    masm85_log *log = (masm85_log *)context;
+    if (log != NULL) {
+        free (log->text);
+        free (log);
+    }
+}
+
+/* appends text to the log given as callback context; prints on stdout without one */
+static void masm85_put (void *context, const char *text) {
+    masm85_log *log = (masm85_log *)context;
+    size_t length;
+
+    if (log == NULL) {
+        fputs (text, stdout);
+        return;
+    }
+    length = strlen (text);
+    if (log->length + length > log->capacity) {
+        size_t capacity = log->capacity == 0 ? 256 : log->capacity;
+        char *temp;
+        while (capacity < log->length + length) {
+            capacity*= 2;
+        }
+        temp = (char *)realloc (log->text, capacity);
+        if (temp == NULL) {
+            /* drop the message rather than the whole log */
+            return;
+        }
+        log->text = temp;
+        log->capacity = capacity;
+    }
+    memcpy (log->text + log->length, text, length);
+    log->length+= length;
+}
+
 void masm85_callback (gat *ga, gat_callback_type type, void *data, void *context) {
     (void)ga;
-    (void)context;
     
     switch (type) {
 #ifdef MASM85_PRINT_TEXT_MESSAGE
     case GAT_CALLBACK_TEXT:
-        printf ("%s\n", (const char *)data);
+        masm85_put (context, (const char *)data);
+        masm85_put (context, "\n");
         break;
 #endif
 
     case GAT_CALLBACK_ERROR: 
       {
         gat_error_info *err = (gat_error_info *)data;
-        if (err->fatal) {           
-            printf ("\"%s\": fatal error %d: line %d -> %s\n", err->file, err->errno, 
-                    err->line, err->desc);
-        } else {
-            printf ("\"%s\": error %d: line %d -> %s\n", err->file, err->errno, 
-                    err->line, err->desc);
-        }
+        char head [GAT_MAX_PATH + 64];
+        sprintf (head, "\"%.*s\": %s %d: line %d -> ", GAT_MAX_PATH, err->file, 
+                 err->fatal ? "fatal error" : (err->warning ? "warning" : "error"), 
+                 err->errno, err->line);
+        masm85_put (context, head);
+        masm85_put (context, err->desc);
+        masm85_put (context, "\n");
       }
       break;
     }
@@ -16,22 +16,22 @@
  * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#include "gat.h"
+#include "masm85.h"
 #include "gat_err.h"
+#include "gat_thread.h"
 #include <stdio.h>
+#include <stdlib.h>
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <tchar.h>
 #endif
 
-#define MASM85_SWITCH_HEX               1
-#define MASM85_SWITCH_85                2
-#define MASM85_SWITCH_O                 4
-#define MASM85_SWITCH_DBG               8
-#define MASM85_SWITCH_HELP              16
+#define MASM85_MAX_JOBS                 256
 
-#define MASM85_VERSION                  "0.0.1"
+/* default cache directory and size limit in KB */
+#define MASM85_CACHE_DIR                ".masm85cache"
+#define MASM85_CACHE_LIMIT              (64 * 1024)
 
 /* define commandline switches */
 static const char *arr_cmdline_switches [/*MASM_NUM_SWITCHES*/] = { 
@@ -39,7 +39,16 @@ static const char *arr_cmdline_switches [/*MASM_NUM_SWITCHES*/] = {
     "-85", 
     "-o", 
     "-dbg", 
-    "-help" 
+    "-help",
+    "-rec",
+    "-j",
+    "-single",
+    "-cache",
+    "-climit",
+    "-stats",
+    "-maxerr",
+    "-pipe",
+    "-mt"
 };
 
 /* define commandline switch flags */
@@ -48,9 +57,21 @@ static uint32_t arr_cmdline_switchflags [/*MASM_NUM_SWITCHES*/] = {
     MASM85_SWITCH_85, 
     MASM85_SWITCH_O, 
     MASM85_SWITCH_DBG, 
-    MASM85_SWITCH_HELP 
+    MASM85_SWITCH_HELP,
+    MASM85_SWITCH_REC,
+    MASM85_SWITCH_J,
+    MASM85_SWITCH_SINGLE,
+    MASM85_SWITCH_CACHE,
+    MASM85_SWITCH_CLIMIT,
+    MASM85_SWITCH_STATS,
+    MASM85_SWITCH_MAXERR,
+    MASM85_SWITCH_PIPE,
+    MASM85_SWITCH_MT
 };
 
+#define MASM85_NUM_SWITCHES \
+(sizeof(arr_cmdline_switches) / sizeof(arr_cmdline_switches[0]))
+
 /* prototypes */
 extern void masm85_hex_emitter (gat *, gat_io *, gat_emitter_state);
 extern void masm85_bin_emitter (gat *, gat_io *, gat_emitter_state);
@@ -58,27 +79,91 @@ extern void masm85_dbg_emitter (gat *, gat_io *, gat_emitter_state);
 
 static void masm85_usage (gat *ga);
 
-/* process command line */  
-void masm85_process_commandline (gat *ga, int argc, char *argv[]) {
-    char input_path [GAT_MAX_PATH];
-    char output_path [GAT_MAX_PATH];
-    char debug_path [GAT_MAX_PATH];
+/* input paths of the batch and output paths given on command line */
+static char **s_input_paths = NULL;
+static unsigned s_num_inputs = 0;
+static unsigned s_max_inputs = 0;
+static char s_output_path [GAT_MAX_PATH];
+static char s_debug_path [GAT_MAX_PATH];
+
+/* number of worker jobs; 0 runs a job per processor */
+static unsigned s_num_jobs = 1;
+
+/* stats report format */
+static int s_stats_format = MASM85_STATS_NONE;
+
+/* adds an input path to the batch */
+static void masm85_add_input (gat *ga, const char *path, size_t length) {
+    char *input_path;
+
+    if (length >= GAT_MAX_PATH) {
+        gat_fatal_error (ga, GAT_ERR_INVALID_INPUT_PATH, "input-path too long : %.*s", 
+                         (int)length, path);
+    }
+    if (s_num_inputs == s_max_inputs) {
+        char **temp;
+        s_max_inputs = s_max_inputs == 0 ? 16 : s_max_inputs * 2;
+        temp = (char **)realloc (s_input_paths, s_max_inputs * sizeof(char *));
+        if (temp == NULL) {
+            gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+        }
+        s_input_paths = temp;
+    }
+    input_path = (char *)malloc (length + 1);
+    if (input_path == NULL) {
+        gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+    }
+    memcpy (input_path, path, length);
+    input_path[length] = '\0';
+    s_input_paths[s_num_inputs++] = input_path;
+}
+
+/* adds input paths listed in a response file; one path per line. empty 
+   lines and lines beginning with ';' are skipped. */
+static void masm85_add_response_file (gat *ga, const char *path) {
+    char line [GAT_MAX_PATH + 2];
+    FILE *fp = fopen (path, "rt");
+
+    if (fp == NULL) {
+        gat_fatal_error (ga, GAT_ERR_FILE_OPEN, "error opening response file: '%s'", path);
+    }
+    while (fgets (line, sizeof(line), fp)) {
+        const char *ptr = line;
+        size_t length = strlen (line);
+        if (length > 0 && line[length - 1] != '\n' && !feof (fp)) {
+            fclose (fp);
+            gat_fatal_error (ga, GAT_ERR_INVALID_INPUT_PATH, "input-path too long in '%s'", path);
+        }
+        length = gat_trim_view (&ptr, length);
+        if (length > 0) {
+            masm85_add_input (ga, ptr, length);
+        }
+    }
+    fclose (fp);
+}
+
+/* process command line; returns number of input files */  
+unsigned masm85_process_commandline (gat *ga, int argc, char *argv[]) {
+    int iarg;
 
      /* [0] = command name, [1] first arg */
     gat_cmdline cmdinfo = { argc - 1, &argv[1] };
 
-    *input_path = *output_path = *debug_path = '\0';
+    *s_output_path = *s_debug_path = '\0';
 
-    /* chek for input path*/
-    if ( (argc > 1) && (argv[1][0] != GAT_CMDLN_SWITCH) ) {
-        strncpy ( input_path, argv[1], GAT_MAX_PATH );
-        gat_attach_io (ga, "rt", input_path, NULL);
+    /* input paths and @response-files come before switches */
+    for (iarg = 1; iarg < argc && argv[iarg][0] != GAT_CMDLN_SWITCH; iarg++) {
+        if (argv[iarg][0] == '@') {
+            masm85_add_response_file (ga, argv[iarg] + 1);
+        } else {
+            masm85_add_input (ga, argv[iarg], strlen(argv[iarg]));
+        }
     }
 
     /* scan command line for switches */
     ga->cmdline_flags = gat_cmdln_scan_switches (&cmdinfo, arr_cmdline_switches, 
                                                     arr_cmdline_switchflags, 
-                                                    GAT_NUM_SWITCHES );
+                                                    MASM85_NUM_SWITCHES );
     
     /* see if -hex and -85 are both specified */
     if ( (ga->cmdline_flags & MASM85_SWITCH_HEX) && 
@@ -87,12 +172,14 @@ void masm85_process_commandline (gat *ga, int argc, char *argv[]) {
     }
     
     /* check for invalid switches */
-    if (input_path[0] == '\0') {
+    if (s_num_inputs == 0) {
         /* these switches can't be used without input-path */
         if ( (ga->cmdline_flags & MASM85_SWITCH_HEX) || 
              (ga->cmdline_flags & MASM85_SWITCH_85) ||
              (ga->cmdline_flags & MASM85_SWITCH_O) || 
-             (ga->cmdline_flags & MASM85_SWITCH_DBG) ) 
+             (ga->cmdline_flags & MASM85_SWITCH_DBG) ||
+             (ga->cmdline_flags & MASM85_SWITCH_REC) ||
+             (ga->cmdline_flags & MASM85_SWITCH_J) ) 
         {
             gat_fatal_error (ga, GAT_ERR_INVALID_INPUT_PATH, "input-path not specified");
         }
@@ -103,60 +190,231 @@ void masm85_process_commandline (gat *ga, int argc, char *argv[]) {
         ga->cmdline_flags|= MASM85_SWITCH_HEX;
     }
 
+    /* HEX record length */
+    if (ga->cmdline_flags & MASM85_SWITCH_REC) {
+        char rec_length[GAT_MAX_PATH];
+        gat_cmdln_get_param ( &cmdinfo, "-rec", rec_length );
+        if ( !gat_is_num (rec_length) || gat_cnum (rec_length) < 1 || 
+             gat_cnum (rec_length) > INTEL_HEX_RECSIZE_LIMIT ) {
+            gat_fatal_error (ga, 1, "-rec expects a record length from 1 to %d", 
+                             INTEL_HEX_RECSIZE_LIMIT);
+        }
+        ga->max_rec_length = (uint16_t)gat_cnum (rec_length);
+    }
+
+    /* engine */
+    if (ga->cmdline_flags & MASM85_SWITCH_SINGLE) {
+        gat_set_engine (ga, GAT_ENGINE_SINGLE_PASS);
+    }
+
+    /* error limit of a source; 0 for no limit */
+    if (ga->cmdline_flags & MASM85_SWITCH_MAXERR) {
+        char max_errors[GAT_MAX_PATH];
+        gat_cmdln_get_param ( &cmdinfo, "-maxerr", max_errors );
+        if ( !gat_is_num (max_errors) ) {
+            gat_fatal_error (ga, 1, "-maxerr expects an error limit; 0 for no limit");
+        }
+        gat_set_max_errors (ga, (unsigned)gat_cnum (max_errors));
+    }
+
+    /* pass #1 pipeline; -pipe alone runs a thread per processor beside the scan */
+    if (ga->cmdline_flags & MASM85_SWITCH_PIPE) {
+        char num_threads[GAT_MAX_PATH];
+        gat_cmdln_get_param ( &cmdinfo, "-pipe", num_threads );
+        if (num_threads[0] == '\0') {
+            unsigned count = gat_num_processors ();
+            gat_set_pipeline (ga, count > 1 ? count - 1 : 1);
+        } else if ( !gat_is_num (num_threads) || gat_cnum (num_threads) < 1 || 
+                    gat_cnum (num_threads) > GAT_PIPE_MAX_THREADS ) {
+            gat_fatal_error (ga, 1, "-pipe expects a number of threads from 1 to %d", 
+                             GAT_PIPE_MAX_THREADS);
+        } else {
+            gat_set_pipeline (ga, (unsigned)gat_cnum (num_threads));
+        }
+    }
+
+    /* parallel engine stages; -mt alone runs a thread per processor */
+    if (ga->cmdline_flags & MASM85_SWITCH_MT) {
+        char num_threads[GAT_MAX_PATH];
+        gat_cmdln_get_param ( &cmdinfo, "-mt", num_threads );
+        if (num_threads[0] == '\0') {
+            gat_set_threads (ga, gat_num_processors ());
+        } else if ( !gat_is_num (num_threads) || gat_cnum (num_threads) < 1 || 
+                    gat_cnum (num_threads) > GAT_PAR_MAX_THREADS ) {
+            gat_fatal_error (ga, 1, "-mt expects a number of threads from 1 to %d", 
+                             GAT_PAR_MAX_THREADS);
+        } else {
+            gat_set_threads (ga, (unsigned)gat_cnum (num_threads));
+        }
+    }
+
+    /* stats report; -statsjson for JSON */
+    if (ga->cmdline_flags & MASM85_SWITCH_STATS) {
+        char format[GAT_MAX_PATH];
+        gat_cmdln_get_param ( &cmdinfo, "-stats", format );
+        if (format[0] == '\0') {
+            s_stats_format = MASM85_STATS_TEXT;
+        } else if (gat_strcmpi (format, "json")) {
+            s_stats_format = MASM85_STATS_JSON;
+        } else {
+            gat_fatal_error (ga, 1, "unknown stats format : %s", format);
+        }
+        gat_set_stats (ga, 1);
+    }
+
+    /* build cache */
+    if (ga->cmdline_flags & MASM85_SWITCH_CACHE) {
+        char cache_dir[GAT_MAX_PATH];
+        unsigned long cache_limit = MASM85_CACHE_LIMIT;
+        gat_cmdln_get_param ( &cmdinfo, "-cache", cache_dir );
+        if (cache_dir[0] == '\0') {
+            strcpy (cache_dir, MASM85_CACHE_DIR);
+        }
+        if (ga->cmdline_flags & MASM85_SWITCH_CLIMIT) {
+            char limit[GAT_MAX_PATH];
+            gat_cmdln_get_param ( &cmdinfo, "-climit", limit );
+            if ( !gat_is_num (limit) || gat_cnum (limit) < 1 ) {
+                gat_fatal_error (ga, 1, "-climit expects cache size limit in KB");
+            }
+            cache_limit = gat_cnum (limit);
+        }
+        masm85_cache_enable (cache_dir, cache_limit * 1024);
+    }
+
+    /* worker jobs; -j alone runs a job per processor */
+    if (ga->cmdline_flags & MASM85_SWITCH_J) {
+        char num_jobs[GAT_MAX_PATH];
+        gat_cmdln_get_param ( &cmdinfo, "-j", num_jobs );
+        if (num_jobs[0] == '\0') {
+            s_num_jobs = 0;
+        } else if ( !gat_is_num (num_jobs) || gat_cnum (num_jobs) < 1 || 
+                    gat_cnum (num_jobs) > MASM85_MAX_JOBS ) {
+            gat_fatal_error (ga, 1, "-j expects a number of jobs from 1 to %d", 
+                             MASM85_MAX_JOBS);
+        } else {
+            s_num_jobs = (unsigned)gat_cnum (num_jobs);
+        }
+    }
+
     /* show usage if -help is present */
     if (ga->cmdline_flags & MASM85_SWITCH_HELP) {
         masm85_usage (ga);
     }
 
-    if (input_path[0] == '\0') {
+    if (s_num_inputs == 0) {
         masm85_usage (ga);
+        return 0;
+    }
+
+    /* output paths */
+    if ( ga->cmdline_flags & MASM85_SWITCH_O ) {
+        gat_cmdln_get_param ( &cmdinfo, "-o", s_output_path );
+        if (s_output_path[0] == '\0') {
+            gat_fatal_error (ga, GAT_ERR_INVALID_OUTPUT_PATH, "output-path not specified");
+        }
+    }
+    if ( ga->cmdline_flags & MASM85_SWITCH_DBG ) {
+        gat_cmdln_get_param ( &cmdinfo, "-dbg", s_debug_path );
+    }
+
+    /* one output path can't serve many inputs */
+    if ( s_num_inputs > 1 && (s_output_path[0] != '\0' || s_debug_path[0] != '\0') ) {
+        gat_fatal_error (ga, GAT_ERR_INVALID_OUTPUT_PATH, 
+                         "output-path can't be specified for multiple input files");
+    }
+
+    return s_num_inputs;
+}
+
+/* attaches input and outputs of the batch input at index */
+void masm85_attach_source (gat *ga, unsigned index) {
+    const char *input_path = s_input_paths[index];
+    char output_path [GAT_MAX_PATH];
+    char debug_path [GAT_MAX_PATH];
+
+    gat_attach_io (ga, "rt", input_path, NULL);
+
+    /* make output path */
+    if (s_output_path[0] != '\0') {
+        strcpy (output_path, s_output_path);
     } else {
-        /* make output path */
-        if ( ga->cmdline_flags & MASM85_SWITCH_O ) {
-            gat_cmdln_get_param ( &cmdinfo, "-o", output_path );
-            if (output_path[0] == '\0') {
-                gat_fatal_error (ga, GAT_ERR_INVALID_OUTPUT_PATH, "output-path not specified");
-            }
+        strcpy (output_path, input_path);
+        /* attach .hex or .85 extension if required */
+        gat_attach_extension ( ga, output_path,
+                                (ga->cmdline_flags & MASM85_SWITCH_HEX) 
+                                ? ".hex" : ".85" );         
+    }
+    /* attach output */
+    gat_attach_io (ga, 
+                    (ga->cmdline_flags & MASM85_SWITCH_HEX) ? "wt" : "wb", 
+                    output_path,
+                    (ga->cmdline_flags & MASM85_SWITCH_HEX) 
+                        ? masm85_hex_emitter 
+                        : masm85_bin_emitter
+                    );
+    
+    /* make debug output path */
+    if ( ga->cmdline_flags & MASM85_SWITCH_DBG ) {
+        if (s_debug_path[0] != '\0') {
+            strcpy (debug_path, s_debug_path);
         } else {
-            ga->cmdline_flags|= MASM85_SWITCH_O;
-            strcpy (output_path, input_path);
-            /* attach .hex or .85 extension if required */
-            gat_attach_extension ( ga, output_path,
-                                    (ga->cmdline_flags & MASM85_SWITCH_HEX) 
-                                    ? ".hex" : ".85" );         
-        }
-        /* attach output */
-        gat_attach_io (ga, 
-                        (ga->cmdline_flags & MASM85_SWITCH_HEX) ? "wt" : "wb", 
-                        output_path,
-                        (ga->cmdline_flags & MASM85_SWITCH_HEX) 
-                            ? masm85_hex_emitter 
-                            : masm85_bin_emitter
-                        );
-        
-        /* make debug output path */
-        if ( ga->cmdline_flags & MASM85_SWITCH_DBG ) {
-            gat_cmdln_get_param ( &cmdinfo, "-dbg", debug_path );
-            if (debug_path[0] == '\0') {
-                strcpy (debug_path, input_path);
-                /* attach .dbg extension if required */
-                gat_attach_extension (ga, debug_path, ".dbg" );
-                gat_attach_io (ga, "wb", debug_path, masm85_dbg_emitter);
-            }
+            strcpy (debug_path, input_path);
+            /* attach .dbg extension if required */
+            gat_attach_extension (ga, debug_path, ".dbg" );
         }
+        gat_attach_io (ga, "wb", debug_path, masm85_dbg_emitter);
     }
 }
 
+/* returns number of worker jobs requested; 0 for a job per processor */
+unsigned masm85_get_jobs (void) {
+    return s_num_jobs;
+}
+
+/* returns stats report format; MASM85_STATS_* */
+int masm85_get_stats (void) {
+    return s_stats_format;
+}
+
+/* frees the batch input list */
+void masm85_free_commandline (void) {
+    unsigned i;
+    for (i = 0; i < s_num_inputs; i++) {
+        free (s_input_paths[i]);
+    }
+    free (s_input_paths);
+    s_input_paths = NULL;
+    s_num_inputs = s_max_inputs = 0;
+}
+
 /* prints the help listing */
 static void masm85_usage (gat *ga) {
     gat_print (ga, "masm85 - micro assembler for Intel 8085 micro processor");
     gat_print (ga, "Version : %s\n", MASM85_VERSION);
     gat_print (
         ga,
-        "Usage: masm85 [<input-path>] [options]\n\n"
+        "Usage: masm85 [<input-path> | @<response-file> ...] [options]\n\n"
         "Options:\n"
         "  [-hex | -85]               : generate HEX or 85 file (default is -hex)\n"
-        "  [-o<output-path>]          : specify output file path\n"
-        "  [-dbg[<debug-ouput-path>]] : generate debug DBG file"
+        "  [-o<output-path>]          : specify output file path"
+        );
+    gat_print (
+        ga,
+        "  [-dbg[<debug-ouput-path>]] : generate debug DBG file\n"
+        "  [-rec<length>]             : HEX data record length 1-255 (default is 16)\n"
+        "  [-j[<jobs>]]               : assemble input files in parallel jobs"
+        );
+    gat_print (
+        ga,
+        "  [-single]                  : assemble in a single pass with fixups\n"
+        "  [-cache[<dir>]]            : restore outputs of unchanged sources from cache\n"
+        "  [-climit<KB>]              : cache size limit (default is 65536 KB)"
+        );
+    gat_print (
+        ga,
+        "  [-stats[json]]             : report phase timings and engine counters\n"
+        "  [-maxerr<count>]           : stop after count errors, 0 for no limit (default is 100)\n"
+        "  [-pipe[<threads>]]         : read and tokenize large sources on threads\n"
+        "  [-mt[<threads>]]           : scan and encode large sources on threads"
         );
 }
@@ -21,22 +21,25 @@
 
 /* emit rountines */
 
-static void masm85_bin_emit_code (gat *ga, gat_io *io) {
-    /* write bytes (binary) to the output file */
-    if ( fwrite (ga->bin, ga->bin_size, 1, ga->ios[1].fp) != 1) {
-        gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "gat_emit() failed to write output file");
+/* writes runs of the memory image in address order; gaps between them are 
+   not filled */
+static void masm85_bin_emit_end_assembly (gat *ga, gat_io *io) {
+    const gat_image *image = ga->image;
+    uint32_t start = 0, length;
+
+    for (; gat_image_next_run (image, &start, &length); start+= length) {
+        if ( fwrite (image->bytes + start, length, 1, io->fp) != 1) {
+            gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "gat_emit() failed to write output file");
+        }
     }
-    ga->offset+= ga->bin_size;
 }
 
 void masm85_bin_emitter (gat *ga, gat_io *io, gat_emitter_state state) {
     switch(state) {
-    case GAT_EMIT_CODE: 
-        masm85_bin_emit_code (ga, io);
+    case GAT_EMIT_END_ASSEMBLY:
+        masm85_bin_emit_end_assembly (ga, io);
         break;
     /* case GAT_EMIT_BEGIN_ASSEMBLY: */
-    /* case GAT_EMIT_END_ASSEMBLY: */
-    /* case GAT_EMIT_SET_ORG: */
     default:
         break;  
     }
@@ -21,39 +21,38 @@
 
 /* emit rountines */
 
-static void masm85_dbg_emit_begin_assembly (gat *ga, gat_io *io) {
-    uint16_t codesize = 0;
-    if ( fwrite(&codesize, sizeof(uint16_t), 1, io->fp) != 1 ) {
-        gat_fatal_error (ga, 1, "failed to write DBG header");
+static void masm85_dbg_write_line (gat *ga, gat_io *io, uint16_t offset, uint32_t line_num) {
+    if ( (fwrite (&offset, sizeof(uint16_t), 1, io->fp) != 1) ||
+         (fwrite (&line_num, sizeof(uint32_t), 1, io->fp) != 1) ) {
+        gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "gat_emit() failed to write debug file");
     }
 }
 
+/* writes the code size followed by the address and source line of each 
+   instruction in the memory image, in address order */
 static void masm85_dbg_emit_end_assembly (gat *ga, gat_io *io) {
-    rewind (io->fp); /* reset cursor pos to write code size */
-    if ( fwrite(&ga->size, sizeof(uint32_t), 1, io->fp) != 1 ) {
-        gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "failed to update DBG header");
-    }
-}
+    const gat_image *image = ga->image;
+    uint32_t start = 0, length, addr;
+    uint16_t codesize = (uint16_t)ga->size;
 
-static void masm85_dbg_emit_code (gat *ga, gat_io *io) {
-    if ( (fwrite (&ga->offset, sizeof(uint16_t), 1, io->fp) != 1) ||
-         (fwrite (&ga->line_num, sizeof(uint32_t), 1, io->fp) != 1) ) {
-        gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "gat_emit() failed to write debug file");
+    if ( fwrite(&codesize, sizeof(uint16_t), 1, io->fp) != 1 ) {
+        gat_fatal_error (ga, GAT_ERR_FILEIO_FAILED, "failed to write DBG header");
+    }
+    for (; gat_image_next_run (image, &start, &length); start+= length) {
+        for (addr = start; addr < start + length; addr++) {
+            if (gat_image_is_start (image, addr)) {
+                masm85_dbg_write_line (ga, io, (uint16_t)addr, image->lines[addr]);
+            }
+        }
     }
 }
 
 void masm85_dbg_emitter (gat *ga, gat_io *io, gat_emitter_state state) {
     switch(state) {
-    case GAT_EMIT_BEGIN_ASSEMBLY:
-        masm85_dbg_emit_begin_assembly (ga, io);
-        break;
     case GAT_EMIT_END_ASSEMBLY:
         masm85_dbg_emit_end_assembly (ga, io);
         break;
-    case GAT_EMIT_CODE: 
-        masm85_dbg_emit_code (ga, io);
-        break;
-    /* case GAT_EMIT_SET_ORG: */
+    /* case GAT_EMIT_BEGIN_ASSEMBLY: */
     default:
         break;  
     }
@@ -19,123 +19,76 @@
 #include "gat.h"
 #include "gat_err.h"
 
-/* writes given bytes to the HEX output file */
-static void gat_write_hex_bytes (gat *ga, const uint8_t *pbytes, unsigned count, gat_io *io) {
-    unsigned i;
-    for (i=0; i < count; i++)  {
-        /* update the checksum first */
-        ga->checksum^= pbytes[i];
-        /* write the HEX bytes */
-        if (pbytes[i] < 16) {
-            fprintf (io->fp, "0%X", pbytes[i]);
-        } else {
-            fprintf (io->fp, "%X", pbytes[i]);
-        }
-    }       
-}
+/* size of the output stream buffer; records reach the file in large writes */
+#define MASM85_HEX_OUTPUT_BUFFER    65536
 
-/* writes EOF record to HEX file */
-static void gat_end_hex_record (gat *ga, gat_io *io) {  
-    fprintf (io->fp, ":00000001FF");
-}
+/* offset of the first data byte in a record text (:LLAAAATT) */
+#define MASM85_HEX_DATA_POS         9
 
-/* begins a new HEX record in HEX file */
-static void gat_begin_hex_record (gat *ga, gat_io *io) {
-    char buff[5];
+static const char s_hex_digits[] = "0123456789ABCDEF";
 
-    /* clear record chesksum */
-    ga->checksum = 0;
+/* puts a byte as two HEX digits */
+#define _put_hex(_p,_b) ((_p)[0] = s_hex_digits[((_b) >> 4) & 0x0F], \
+                         (_p)[1] = s_hex_digits[(_b) & 0x0F])
 
-    /* reset record length */
-    ga->rec_length = 0;
-    
-    /* mark start of hex record; this is required later when updating the record */
-    ga->offset_hexrec = (uint16_t) ftell( ga->ios[1].fp);
-    
-    fprintf (io->fp, ":00%s00", gat_chex16((uint16_t)ga->offset,buff));
-}
+/* writes a HEX data record of count bytes loaded at address */
+static void gat_write_hex_record (gat *ga, gat_io *io, uint32_t address, 
+                                  const uint8_t *pbytes, unsigned count) {
+    char *ptr = ga->hex_record;
+    uint8_t sum = 0;
+    unsigned i;
 
-/* updates HEX record in HEX file */
-static void gat_update_hex_record (gat *ga, gat_io *io) {
-    /* update checksum */
-    ga->checksum^= ga->rec_length;
-    ga->checksum^= (uint8_t )ga->offset;
-    ga->checksum^= (ga->offset>>8)&0x0FF;
-    ga->checksum = ~ga->checksum;
-
-    /* write checksum */
-    if (ga->checksum < 16) {
-        fprintf ( io->fp, "%0X", ga->checksum);
-    } else {
-        fprintf ( io->fp, "%X", ga->checksum);
+    *ptr = ':';
+    _put_hex (ptr + 1, count);
+    _put_hex (ptr + 3, (address >> 8) & 0x0FF);
+    _put_hex (ptr + 5, address & 0x0FF);
+    _put_hex (ptr + 7, INTEL_HEX_RECTYPE_DATA);
+
+    ptr+= MASM85_HEX_DATA_POS;
+    for (i = 0; i < count; i++) {
+        sum+= pbytes[i];
+        _put_hex (ptr, pbytes[i]);
+        ptr+= 2;
     }
 
-    /* seek to start of HEX record */
-    fseek ( io->fp, ga->offset_hexrec + sizeof(char), SEEK_SET );
+    /* checksum is the two's complement of the sum of the record bytes; the 
+       data record type adds nothing */
+    sum+= (uint8_t)count;
+    sum+= (uint8_t)address;
+    sum+= (address >> 8) & 0x0FF;
 
-    /* write updated length */
-    if (ga->rec_length < 16) {
-        fprintf (io->fp, "0%X", ga->rec_length);
-    } else {
-        fprintf (io->fp, "%X", ga->rec_length);
-    }
-    
-    /* move to end of record */
-    fseek (io->fp, 0, SEEK_END);
+    /* put checksum and CR+LF */
+    _put_hex (ptr, (uint8_t)(0 - sum));
+    ptr[2] = '\r';
+    ptr[3] = '\n';
 
-    /* write CR+LF */
-    fprintf (io->fp, "\r\n");
+    fwrite (ga->hex_record, sizeof(char), ptr + 4 - ga->hex_record, io->fp);
+}
+
+/* writes EOF record to HEX file */
+static void gat_end_hex_record (gat *ga, gat_io *io) {  
+    fputs (":00000001FF", io->fp);
 }
 
 /* emit routines */
 
 static void masm85_hex_emit_begin_assembly (gat *ga, gat_io *io) {
-    gat_begin_hex_record (ga, io);
+    setvbuf (io->fp, NULL, _IOFBF, MASM85_HEX_OUTPUT_BUFFER);
 }
 
+/* writes runs of the memory image in address order; each run is split in 
+   records of max_rec_length bytes */
 static void masm85_hex_emit_end_assembly (gat *ga, gat_io *io) {
-    gat_update_hex_record (ga, io);
-    gat_end_hex_record (ga, io);
-}
+    const gat_image *image = ga->image;
+    uint32_t start = 0, length, count;
 
-static void masm85_hex_emit_code (gat *ga, gat_io *io) {
-    /* if record length >= INTEL_MAX_HEX_RECSIZE then we must terminate the 
-           record forcefully */
-    if ( (ga->rec_length + ga->bin_size) >= INTEL_MAX_HEX_RECSIZE ) {
-        unsigned rem;
-
-        /* find number of bytes that can't be put in the current record */
-        rem = (ga->rec_length + ga->bin_size) - INTEL_MAX_HEX_RECSIZE;
-
-        /* write new bytes in the current record */
-        gat_write_hex_bytes (ga, ga->bin, ga->bin_size - rem, io);
-        ga->rec_length+= (ga->bin_size - rem);
-
-        gat_update_hex_record (ga, io);
-
-        /* update the offset discarding the remaining bytes */
-        ga->offset+= (ga->bin_size - rem);
-
-        /* begin new record */
-        gat_begin_hex_record (ga, io);
-
-        /* write new bytes */
-        gat_write_hex_bytes (ga, ga->bin + (ga->bin_size - rem), rem, io);
-        ga->rec_length+= rem;
-
-        ga->offset+= rem;
-    } else {
-        /* write new bytes */
-        gat_write_hex_bytes (ga, ga->bin, ga->bin_size, io);
-        ga->rec_length+= ga->bin_size;
-
-        ga->offset+= ga->bin_size;
+    while (gat_image_next_run (image, &start, &length)) {
+        for (; length > 0; start+= count, length-= count) {
+            count = length < ga->max_rec_length ? length : ga->max_rec_length;
+            gat_write_hex_record (ga, io, start, image->bytes + start, count);
+        }
     }
-}
-
-static void masm85_hex_set_org (gat *ga, gat_io *io) {
-    gat_update_hex_record (ga, io);
-    gat_begin_hex_record (ga, io);
+    gat_end_hex_record (ga, io);
 }
 
 void masm85_hex_emitter (gat *ga, gat_io *io, gat_emitter_state state) {
@@ -146,12 +99,6 @@ void masm85_hex_emitter (gat *ga, gat_io *io, gat_emitter_state state) {
     case GAT_EMIT_END_ASSEMBLY:
         masm85_hex_emit_end_assembly (ga, io);
         break;
-    case GAT_EMIT_CODE: 
-        masm85_hex_emit_code (ga, io);
-        break;
-    case GAT_EMIT_SET_ORG:
-        masm85_hex_set_org (ga, io);
-        break;
     default:
         break;  
     }
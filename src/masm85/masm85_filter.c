@@ -22,7 +22,7 @@
 /* returns 1 if instruction is allowed otherwise 0 */
 int masm85_filter (gat *ga) {
     #define CHECK(_I,_S) \
-    (gat_strcmpi(ga->arr_tokens[(_I)],(_S)))
+    (gat_token_equi(&ga->arr_raw_tokens[(_I)],(_S)))
     
     int invalid = 0;
 
@@ -41,7 +41,8 @@ int masm85_filter (gat *ga) {
         invalid = CHECK(1,"psw");
     }
     else if ( CHECK(0,"rst") ) {
-        invalid = (gat_cbyte(ga->arr_tokens[1]) > 7);
+        /* ids and expressions are checked as numbers only */
+        invalid = gat_token_is_byte(ga, 1) && gat_token_value(ga, 1) > 7;
     }
 
     return !invalid;
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* masm85_jobs.c  assembles batch inputs in parallel worker jobs. */
+#include <stdio.h>
+#include <stdlib.h>
+#include "masm85.h"
+#include "gat_err.h"
+#include "gat_thread.h"
+
+/* a batch input assembled by a worker */
+typedef struct _masm85_job {
+    masm85_result result;
+    void *log;                  /* messages of the job */
+}masm85_job;
+
+/* work shared by the workers */
+typedef struct _masm85_pool {
+    const gat *options;         /* assembler carrying the command line options */
+    masm85_job *jobs;
+    unsigned num_jobs;
+    unsigned next_job;          /* next input to assemble; guarded by s_jobs_mutex */
+}masm85_pool;
+
+/* one batch runs at a time */
+static gat_mutex s_jobs_mutex = GAT_MUTEX_INIT;
+
+/* assembles inputs until the pool runs out of them. each worker owns an 
+   assembler which is reset between inputs. a worker without memory for its 
+   assembler leaves the inputs to the others. */
+static void masm85_worker (void *param) {
+    masm85_pool *pool = (masm85_pool *)param;
+    gat *ga = (gat *)malloc (sizeof(gat));
+    unsigned index;
+
+    if (ga == NULL) {
+        return;
+    }
+    masm85_init (ga);
+    ga->cmdline_flags = pool->options->cmdline_flags;
+    ga->max_rec_length = pool->options->max_rec_length;
+    gat_set_engine (ga, pool->options->engine);
+    gat_set_stats (ga, pool->options->stats_enabled);
+    gat_set_max_errors (ga, pool->options->max_errors);
+    gat_set_pipeline (ga, pool->options->num_pipe_threads);
+    gat_set_threads (ga, pool->options->num_threads);
+
+    for (;;) {
+        masm85_job *job;
+
+        gat_mutex_lock (&s_jobs_mutex);
+        index = pool->next_job++;
+        gat_mutex_unlock (&s_jobs_mutex);
+        if (index >= pool->num_jobs) {
+            break;
+        }
+
+        job = pool->jobs + index;
+        gat_set_callback (ga, masm85_callback, job->log);
+        masm85_assemble_input (ga, index, &job->result);
+        gat_reset (ga);
+    }
+
+    gat_cleanup (ga);
+    free (ga);
+}
+
+/* assembles num_inputs batch inputs with up to num_jobs workers; 0 runs a 
+   worker per processor. messages of each input are printed in input order 
+   once the batch is done. results are added to the batch totals. */
+void masm85_run_jobs (gat *ga, unsigned num_inputs, unsigned num_jobs, masm85_totals *totals) {
+    masm85_pool pool;
+    gat_thread *threads;
+    unsigned num_threads, i;
+
+    if (num_jobs == 0) {
+        num_jobs = gat_num_processors ();
+    }
+    num_threads = num_jobs < num_inputs ? num_jobs : num_inputs;
+
+    pool.options = ga;
+    pool.num_jobs = num_inputs;
+    pool.next_job = 0;
+    pool.jobs = (masm85_job *)calloc (num_inputs, sizeof(masm85_job));
+    threads = (gat_thread *)calloc (num_threads, sizeof(gat_thread));
+    if (pool.jobs == NULL || threads == NULL) {
+        free (pool.jobs);
+        free (threads);
+        gat_fatal_error (ga, GAT_ERR_OUT_OF_MEMORY, "out of memory");
+    }
+    for (i = 0; i < num_inputs; i++) {
+        pool.jobs[i].result.exit_code = -1;
+        pool.jobs[i].result.cache_hit = -1;
+        pool.jobs[i].log = masm85_log_create ();
+    }
+
+    /* start workers; the batch still completes if fewer threads start */
+    for (i = 0; i < num_threads; i++) {
+        if (!gat_thread_start (&threads[i], masm85_worker, &pool)) {
+            break;
+        }
+    }
+    num_threads = i;
+    if (num_threads == 0) {
+        masm85_worker (&pool);
+    }
+
+    /* wait for workers */
+    for (i = 0; i < num_threads; i++) {
+        gat_thread_join (&threads[i]);
+    }
+
+    /* report inputs in order. inputs are taken in order, so those from 
+       next_job on were left when no worker got memory for its assembler. */
+    for (i = 0; i < num_inputs; i++) {
+        masm85_job *job = pool.jobs + i;
+        if (job->log != NULL) {
+            masm85_log_flush (job->log, stdout);
+            masm85_log_free (job->log);
+        }
+        if (i >= pool.next_job) {
+            printf ("out of memory\n");
+            job->result.exit_code = GAT_ERR_OUT_OF_MEMORY;
+            job->result.fatal_error = GAT_ERR_OUT_OF_MEMORY;
+        }
+        masm85_add_result (totals, &job->result);
+    }
+
+    free (threads);
+    free (pool.jobs);
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** masm85_keywords.c  perfect hash keyword table; generated by masm85_kwgen 
+    from masm85_table.c. do not edit. */
+#include "gat.h"
+
+static const uint16_t s_disp [64] = {
+    2, 0, 0, 0, 0, 0, 5, 0, 1, 0, 0, 2, 15, 0, 1, 3,
+    5, 1, 0, 0, 6, 3, 8, 2, 0, 4, 0, 0, 5, 0, 5, 0,
+    0, 0, 0, 11, 0, 4, 0, 0, 0, 0, 0, 6, 1, 1, 3, 0,
+    0, 0, 2, 4, 8, 0, 0, 0, 0, 0, 1, 0, 2, 0, 4, 5,
+};
+
+static const int16_t s_slots [256] = {
+    40, /* lhld */
+    GAT_KW_DIRT | 3, /* : */
+    31, /* jmp */
+    33, /* jnz */
+    77, /* xra */
+    34, /* jp */
+    30, /* jm */
+    GAT_KW_DIRT | 7, /* if */
+    29, /* jc */
+    45, /* ora */
+    37, /* jz */
+    32, /* jnc */
+    26, /* in */
+    78, /* xri */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    74, /* sub */
+    75, /* sui */
+    71, /* sta */
+    53, /* rc */
+    57, /* rm */
+    60, /* rp */
+    73, /* stc */
+    25, /* hlt */
+    65, /* rz */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    43, /* mvi */
+    GAT_KW_NONE,
+    79, /* xthl */
+    GAT_KW_DIRT | 2, /* end */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    42, /* mov */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_DIRT | 0, /* equ */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    76, /* xchg */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_DIRT | 6, /* include */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    44, /* nop */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_DIRT | 4, /* macro */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    70, /* sphl */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    50, /* push */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    62, /* rpo */
+    GAT_KW_NONE,
+    61, /* rpe */
+    GAT_KW_NONE,
+    38, /* lda */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    63, /* rrc */
+    GAT_KW_NONE,
+    64, /* rst */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    41, /* lxi */
+    72, /* stax */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    15, /* cpe */
+    17, /* cpo */
+    16, /* cpi */
+    68, /* shld */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    28, /* inx */
+    52, /* rar */
+    27, /* inr */
+    GAT_KW_NONE,
+    51, /* ral */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    54, /* ret */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    55, /* rim */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    56, /* rlc */
+    GAT_KW_DIRT | 9, /* else */
+    GAT_KW_DIRT | 10, /* endif */
+    48, /* pchl */
+    GAT_KW_NONE,
+    GAT_KW_DIRT | 8, /* ifdef */
+    59, /* rnz */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_DIRT | 5, /* endm */
+    GAT_KW_NONE,
+    58, /* rnc */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    13, /* cnz */
+    GAT_KW_NONE,
+    9, /* cma */
+    12, /* cnc */
+    10, /* cmc */
+    49, /* pop */
+    11, /* cmp */
+    21, /* dcr */
+    22, /* dcx */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    20, /* dad */
+    GAT_KW_NONE,
+    19, /* daa */
+    GAT_KW_NONE,
+    35, /* jpe */
+    4, /* ana */
+    66, /* sbb */
+    36, /* jpo */
+    67, /* sbi */
+    5, /* ani */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    0, /* aci */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    6, /* call */
+    14, /* cp */
+    18, /* cz */
+    GAT_KW_NONE,
+    7, /* cc */
+    1, /* adc */
+    8, /* cm */
+    2, /* add */
+    3, /* adi */
+    GAT_KW_NONE,
+    GAT_KW_NONE,
+    69, /* sim */
+    47, /* out */
+    39, /* ldax */
+    24, /* ei */
+    46, /* ori */
+    GAT_KW_DIRT | 1, /* org */
+    23, /* di */
+};
+
+const gat_kwtable g_kw_table = { 1u, 64, 256, s_disp, s_slots };
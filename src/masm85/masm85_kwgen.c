@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** masm85_kwgen.c  generates the perfect hash keyword table (masm85_keywords.c) 
+    from the directive and instruction tables in masm85_table.c. */
+#include <stdio.h>
+#include <stdlib.h>
+#include "gat.h"
+
+/* externs */
+extern const gat_dirt g_dirt_table[];
+extern const gat_instr g_instr_table[];
+extern const unsigned g_len_dirt_table;
+extern const unsigned g_len_instr_table;
+
+#define KWGEN_MAX_KEYWORDS          1024
+#define KWGEN_MAX_SEEDS             1000000
+
+typedef struct _kwgen_key {
+    const char *text;
+    int code;
+    uint32_t hash;
+}kwgen_key;
+
+static kwgen_key s_keys[KWGEN_MAX_KEYWORDS];
+static unsigned s_num_keys;
+
+/* tries to place all keywords with seed; buckets get a displacement that 
+   moves all of their keywords to free slots. returns 0 if it fails. */
+static int kwgen_place (uint32_t seed, unsigned num_buckets, unsigned num_slots, 
+                        uint16_t *disp, int16_t *slots) {
+    unsigned bucket_size[KWGEN_MAX_KEYWORDS];
+    unsigned taken[KWGEN_MAX_KEYWORDS];
+    unsigned i, b, size, d, num_taken;
+
+    for (i = 0; i < num_slots; i++) {
+        slots[i] = GAT_KW_NONE;
+    }
+    for (b = 0; b < num_buckets; b++) {
+        bucket_size[b] = 0;
+        disp[b] = 0;
+    }
+    for (i = 0; i < s_num_keys; i++) {
+        s_keys[i].hash = gat_hash_keyword (seed, s_keys[i].text, strlen(s_keys[i].text));
+        ++bucket_size[s_keys[i].hash & (num_buckets - 1)];
+    }
+
+    /* place larger buckets first */
+    for (size = s_num_keys; size > 0; size--) {
+        for (b = 0; b < num_buckets; b++) {
+            if (bucket_size[b] != size) {
+                continue;
+            }
+            for (d = 0; d < num_slots; d++) {
+                num_taken = 0;
+                for (i = 0; i < s_num_keys; i++) {
+                    unsigned slot = ((s_keys[i].hash >> 16) + d) & (num_slots - 1);
+                    if ( (s_keys[i].hash & (num_buckets - 1)) != b ) {
+                        continue;
+                    }
+                    if (slots[slot] != GAT_KW_NONE) {
+                        break;
+                    }
+                    slots[slot] = (int16_t)s_keys[i].code;
+                    taken[num_taken++] = slot;
+                }
+                if (num_taken == size) {
+                    break;
+                }
+                /* collision; free the slots of this bucket and try next */
+                while (num_taken > 0) {
+                    slots[taken[--num_taken]] = GAT_KW_NONE;
+                }
+            }
+            if (d == num_slots) {
+                return 0;
+            }
+            disp[b] = (uint16_t)d;
+        }
+    }
+
+    return 1;
+}
+
+int main (int argc, char *argv[]) {
+    unsigned num_buckets, num_slots, i, j;
+    uint16_t disp[KWGEN_MAX_KEYWORDS];
+    int16_t slots[KWGEN_MAX_KEYWORDS * 4];
+    uint32_t seed;
+
+    /* collect keywords */
+    if (g_len_dirt_table + g_len_instr_table > KWGEN_MAX_KEYWORDS) {
+        fprintf (stderr, "masm85_kwgen: too many keywords\n");
+        return 1;
+    }
+    for (i = 0; i < g_len_dirt_table; i++) {
+        s_keys[s_num_keys].text = g_dirt_table[i].command;
+        s_keys[s_num_keys++].code = GAT_KW_DIRT | i;
+    }
+    for (i = 0; i < g_len_instr_table; i++) {
+        s_keys[s_num_keys].text = g_instr_table[i].mnemonic;
+        s_keys[s_num_keys++].code = i;
+    }
+
+    /* keywords must be unique ignoring case */
+    for (i = 0; i < s_num_keys; i++) {
+        for (j = i + 1; j < s_num_keys; j++) {
+            if (gat_strcmpi_view (s_keys[i].text, s_keys[j].text, strlen(s_keys[j].text)) == 0) {
+                fprintf (stderr, "masm85_kwgen: duplicate keyword : %s\n", s_keys[i].text);
+                return 1;
+            }
+        }
+    }
+
+    /* about 1.5 slots per keyword and 2 keywords per bucket */
+    for (num_slots = 1; num_slots * 2 < s_num_keys * 3; num_slots*= 2);
+    for (num_buckets = 1; num_buckets * 2 < s_num_keys; num_buckets*= 2);
+
+    for (seed = 1; seed <= KWGEN_MAX_SEEDS; seed++) {
+        if (kwgen_place (seed, num_buckets, num_slots, disp, slots)) {
+            break;
+        }
+    }
+    if (seed > KWGEN_MAX_SEEDS) {
+        fprintf (stderr, "masm85_kwgen: no perfect hash found\n");
+        return 1;
+    }
+
+    /* write the table */
+    printf ("/*\n");
+    printf (" * Copyright 2017, Bal Chettri\n");
+    printf (" * \n");
+    printf (" * Permission is hereby granted, free of charge, to any person obtaining a copy of this software \n");
+    printf (" * and associated documentation files (the \"Software\"), to deal in the Software without restriction, \n");
+    printf (" * including without limitation the rights to use, copy, modify, merge, publish, distribute, \n");
+    printf (" * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is \n");
+    printf (" * furnished to do so, subject to the following conditions:\n");
+    printf (" * \n");
+    printf (" * The above copyright notice and this permission notice shall be included in all copies or substantial \n");
+    printf (" * portions of the Software.\n");
+    printf (" * \n");
+    printf (" * THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT \n");
+    printf (" * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. \n");
+    printf (" * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, \n");
+    printf (" * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE \n");
+    printf (" * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.\n");
+    printf (" */\n");
+    printf ("/** masm85_keywords.c  perfect hash keyword table; generated by masm85_kwgen \n");
+    printf ("    from masm85_table.c. do not edit. */\n");
+    printf ("#include \"gat.h\"\n\n");
+
+    printf ("static const uint16_t s_disp [%u] = {", num_buckets);
+    for (i = 0; i < num_buckets; i++) {
+        printf ("%s%u,", (i % 16) ? " " : "\n    ", disp[i]);
+    }
+    printf ("\n};\n\n");
+
+    printf ("static const int16_t s_slots [%u] = {", num_slots);
+    for (i = 0; i < num_slots; i++) {
+        if (slots[i] == GAT_KW_NONE) {
+            printf ("\n    GAT_KW_NONE,");
+        } else if (slots[i] & GAT_KW_DIRT) {
+            printf ("\n    GAT_KW_DIRT | %d, /* %s */", slots[i] & ~GAT_KW_DIRT, 
+                    g_dirt_table[slots[i] & ~GAT_KW_DIRT].command);
+        } else {
+            printf ("\n    %d, /* %s */", slots[i], g_instr_table[slots[i]].mnemonic);
+        }
+    }
+    printf ("\n};\n\n");
+
+    printf ("const gat_kwtable g_kw_table = { %luu, %u, %u, s_disp, s_slots };\n", 
+            (unsigned long)seed, num_buckets, num_slots);
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** masm85_lib.c  masm85 assembler setup and the libgat in-memory API. */
+#include <stdlib.h>
+#include "masm85.h"
+#include "libgat.h"
+#include "gat_err.h"
+
+/* externs */
+extern const gat_arch masm85_arch;
+extern const gat_dirt g_dirt_table[];
+extern const gat_instr g_instr_table[];
+extern const unsigned g_len_dirt_table;
+extern const unsigned g_len_instr_table;
+extern const gat_kwtable g_kw_table;
+
+/* initial capacities; arrays double from here */
+#define LIBGAT_INIT_DIAGS           16
+#define LIBGAT_INIT_TEXT            1024
+
+/* libgat handle */
+struct _libgat {
+    gat ga;
+    libgat_diag *diags;
+    size_t *diag_text;          /* offset of each diagnostic text in text; its file 
+                                   follows it */
+    unsigned num_diags;
+    unsigned max_diags;
+    char *text;                 /* diagnostic texts */
+    size_t text_size;
+    size_t max_text_size;
+    libgat_symbol *symbols;
+    unsigned max_symbols;
+    char include_dir [GAT_MAX_PATH + 1];    /* empty rejects INCLUDE */
+};
+
+/* initializes an assembler for masm85 */
+void masm85_init (gat *ga) {
+    gat_init (ga, &masm85_arch, g_dirt_table, g_len_dirt_table, g_instr_table, g_len_instr_table);
+    gat_set_keywords ( ga, &g_kw_table );
+}
+
+/* grows an array to hold count elements; returns 0 if out of memory */
+static int libgat_grow (void **arr, size_t elem_size, size_t count, size_t *capacity, 
+                        size_t init_capacity) {
+    size_t new_capacity = *capacity > 0 ? *capacity : init_capacity;
+    void *temp;
+
+    if (count <= *capacity) {
+        return 1;
+    }
+    while (new_capacity < count) {
+        new_capacity*= 2;
+    }
+    temp = realloc (*arr, new_capacity * elem_size);
+    if (temp == NULL) {
+        return 0;
+    }
+    *arr = temp;
+    *capacity = new_capacity;
+    return 1;
+}
+
+/* collects diagnostics of the handle; text messages are dropped. a diagnostic 
+   that can't be stored for lack of memory is only counted. */
+static void libgat_callback (gat *ga, gat_callback_type type, void *data, void *ctx) {
+    libgat *lg = (libgat *)ctx;
+    const gat_error_info *err = (const gat_error_info *)data;
+    const char *file;
+    size_t len, file_len, capacity;
+    libgat_diag *diag;
+
+    if (type != GAT_CALLBACK_ERROR) {
+        return;
+    }
+
+    file = err->file != NULL ? err->file : "";
+    len = strlen (err->desc) + 1;
+    file_len = strlen (file) + 1;
+    capacity = lg->max_diags;
+    if ( !libgat_grow ((void **)&lg->diags, sizeof(libgat_diag), lg->num_diags + 1, 
+                        &capacity, LIBGAT_INIT_DIAGS) ) {
+        return;
+    }
+    capacity = lg->max_diags;
+    if ( !libgat_grow ((void **)&lg->diag_text, sizeof(size_t), lg->num_diags + 1, 
+                        &capacity, LIBGAT_INIT_DIAGS) ) {
+        return;
+    }
+    lg->max_diags = (unsigned)capacity;
+    if ( !libgat_grow ((void **)&lg->text, 1, lg->text_size + len + file_len, 
+                        &lg->max_text_size, LIBGAT_INIT_TEXT) ) {
+        return;
+    }
+
+    /* texts move as the buffer grows; they are resolved once assembly is done */
+    memcpy (lg->text + lg->text_size, err->desc, len);
+    memcpy (lg->text + lg->text_size + len, file, file_len);
+    lg->diag_text[lg->num_diags] = lg->text_size;
+    lg->text_size+= len + file_len;
+
+    diag = lg->diags + lg->num_diags++;
+    diag->kind = err->fatal ? LIBGAT_DIAG_FATAL : 
+                 (err->warning ? LIBGAT_DIAG_WARNING : LIBGAT_DIAG_ERROR);
+    diag->code = err->errno;
+    diag->line = err->line > 0 ? (unsigned)err->line : 0;
+    diag->text = NULL;
+    diag->file = NULL;
+}
+
+/* lists equs then labels of the last assembly in result */
+static void libgat_get_symbols (libgat *lg, libgat_result *result) {
+    gat *ga = &lg->ga;
+    unsigned count = ga->num_ids + ga->num_labels;
+    size_t capacity = lg->max_symbols;
+    libgat_symbol *sym;
+    unsigned i;
+
+    if ( !libgat_grow ((void **)&lg->symbols, sizeof(libgat_symbol), count, &capacity, 
+                        LIBGAT_INIT_DIAGS) ) {
+        return;
+    }
+    lg->max_symbols = (unsigned)capacity;
+
+    sym = lg->symbols;
+    for (i = 0; i < ga->num_ids; i++, sym++) {
+        const gat_id *id = ga->arr_ids + i;
+        sym->name = ga->symtab.names + id->name;
+        sym->kind = id->idtype == GAT_IDTYPE_DBL ? LIBGAT_SYM_WORD : LIBGAT_SYM_BYTE;
+        sym->value = id->data;
+    }
+    for (i = 0; i < ga->num_labels; i++, sym++) {
+        const gat_label *label = ga->arr_labels + i;
+        sym->name = ga->symtab.names + label->name;
+        sym->kind = LIBGAT_SYM_LABEL;
+        sym->value = label->address;
+    }
+
+    result->symbols = lg->symbols;
+    result->num_symbols = count;
+}
+
+int libgat_version (void) {
+    return LIBGAT_API_VERSION;
+}
+
+libgat *libgat_create (void) {
+    libgat *lg = (libgat *)calloc (1, sizeof(libgat));
+
+    if (lg != NULL) {
+        masm85_init (&lg->ga);
+        gat_set_callback (&lg->ga, libgat_callback, lg);
+    }
+    return lg;
+}
+
+void libgat_set_max_errors (libgat *lg, unsigned max_errors) {
+    gat_set_max_errors (&lg->ga, max_errors);
+}
+
+/* a directory too long to hold is taken as none; INCLUDE then fails rather 
+   than reading from an unintended place */
+void libgat_set_include_dir (libgat *lg, const char *dir) {
+    size_t len = dir != NULL ? strlen (dir) : 0;
+
+    if (len == 0 || len > GAT_MAX_PATH) {
+        lg->include_dir[0] = '\0';
+        gat_set_include_dir (&lg->ga, NULL);
+        return;
+    }
+    memcpy (lg->include_dir, dir, len + 1);
+    gat_set_include_dir (&lg->ga, lg->include_dir);
+}
+
+/* assembles source; tables, IR, image and result arrays of the handle are 
+   reused from one assembly to the next */
+int libgat_assemble (libgat *lg, const char *name, const char *source, size_t size, 
+                     int flags, libgat_result *result) {
+    gat *ga = &lg->ga;
+    unsigned i;
+    int exit_code;
+
+    gat_reset (ga);
+    lg->num_diags = 0;
+    lg->text_size = 0;
+
+    gat_set_engine (ga, (flags & LIBGAT_SINGLE_PASS) ? GAT_ENGINE_SINGLE_PASS : 
+                                                       GAT_ENGINE_TWO_PASS);
+    gat_set_source (ga, name != NULL ? name : "<memory>", source, size);
+    exit_code = gat_engine (ga);
+    gat_close (ga);
+
+    memset (result, 0, sizeof(libgat_result));
+    result->status = ga->fatal_error ? ga->fatal_error : exit_code;
+    result->err_count = ga->err_count;
+    result->warn_count = ga->warn_count;
+    if (result->status == 0 && ga->image != NULL) {
+        result->size = ga->size;
+        result->image = ga->image->bytes;
+        result->coverage = ga->image->coverage;
+    }
+
+    for (i = 0; i < lg->num_diags; i++) {
+        lg->diags[i].text = lg->text + lg->diag_text[i];
+        lg->diags[i].file = lg->diags[i].text + strlen (lg->diags[i].text) + 1;
+    }
+    result->diags = lg->diags;
+    result->num_diags = lg->num_diags;
+
+    libgat_get_symbols (lg, result);
+    return result->status;
+}
+
+int libgat_next_run (const libgat *lg, unsigned *start, unsigned *length) {
+    uint32_t run_start = *start, run_length;
+
+    if (lg->ga.image == NULL || lg->ga.err_count > 0 || 
+        !gat_image_next_run (lg->ga.image, &run_start, &run_length)) {
+        return 0;
+    }
+    *start = run_start;
+    *length = run_length;
+    return 1;
+}
+
+void libgat_destroy (libgat *lg) {
+    if (lg != NULL) {
+        gat_cleanup (&lg->ga);
+        free (lg->diags);
+        free (lg->diag_text);
+        free (lg->text);
+        free (lg->symbols);
+        free (lg);
+    }
+}
@@ -23,17 +23,56 @@
 #include <tchar.h>
 #endif
 #include <stdio.h>
-#include "gat.h"
+#include <stdlib.h>
+#include "masm85.h"
 #include "gat_err.h"
+#include "gat_include.h"
 
-/* externs */
-extern void masm85_callback (gat *, gat_callback_type, void *, void *);
-extern void masm85_process_commandline (gat *ga, int argc, char *argv[]);
-extern gat_arch masm85_arch;
-extern gat_dirt g_dirt_table[];
-extern gat_instr g_instr_table[];
-extern unsigned g_len_dirt_table;
-extern unsigned g_len_instr_table;
+/* assembles the batch input at index and closes it. with -cache outputs of an 
+   unchanged source are restored from the cache instead. */
+void masm85_assemble_input (gat *ga, unsigned index, masm85_result *result) {
+    uint64_t key;
+
+    masm85_attach_source (ga, index);
+
+    result->cache_hit = masm85_cache_restore (ga, &key);
+    if (result->cache_hit == 1) {
+        result->exit_code = 0;
+    } else {
+        result->exit_code = gat_engine (ga);
+    }
+    result->fatal_error = ga->fatal_error;
+    result->err_count = ga->err_count;
+    result->warn_count = ga->warn_count;
+    gat_close (ga);
+    result->stats = ga->stats;
+
+    /* only clean results are cached; a hit can't repeat the messages. outputs 
+       of sources including files depend on more than the source bytes. */
+    if (result->cache_hit == 0 && ga->err_count == 0 && ga->warn_count == 0 && 
+        ga->stats.includes == 0) {
+        masm85_cache_store (ga, key);
+    }
+}
+
+/* adds result of a batch input to the totals. exit code of the batch is the 
+   first fatal error number, or -1 if some input failed. */
+void masm85_add_result (masm85_totals *totals, const masm85_result *result) {
+    if (result->exit_code != 0) {
+        if ( totals->exit_code == 0 || (result->fatal_error && totals->exit_code == -1) ) {
+            totals->exit_code = result->fatal_error ? result->fatal_error : -1;
+        }
+        ++totals->num_failed;
+    }
+    totals->err_count+= result->err_count;
+    totals->warn_count+= result->warn_count;
+    if (result->cache_hit == 1) {
+        ++totals->cache_hits;
+    } else if (result->cache_hit == 0) {
+        ++totals->cache_misses;
+    }
+    gat_stats_add (&totals->stats, &result->stats);
+}
 
 #ifdef WINDOWS
 int _tmain(int argc, _TCHAR* argv[]) {
@@ -41,18 +80,61 @@ int _tmain(int argc, _TCHAR* argv[]) {
 int main (int argc, char *argv[]) {
 #endif
     /* invoke the gat assembler */
-    int exitcode = 0;
-    gat _ga, *ga = &_ga;
-    
-    gat_init (ga, &masm85_arch, g_dirt_table, g_len_dirt_table, g_instr_table, g_len_instr_table);
+    unsigned num_inputs, num_jobs, i;
+    uint64_t start_wall, end_wall, cpu;
+    masm85_totals totals;
+    gat *ga;
+
+    /* the assembler state is large; keep it off the stack */
+    ga = (gat *)malloc (sizeof(gat));
+    if (ga == NULL) {
+        printf ("out of memory\n");
+        return GAT_ERR_OUT_OF_MEMORY;
+    }
+    masm85_init (ga);
     gat_set_callback ( ga, masm85_callback, NULL );
 
-    masm85_process_commandline ( ga, argc, argv );
-    if (ga->num_ios > 0) {
-        exitcode = gat_engine (ga);
+    num_inputs = masm85_process_commandline ( ga, argc, argv );
+    num_jobs = masm85_get_jobs ();
+
+    memset (&totals, 0, sizeof(totals));
+    gat_clock (&start_wall, &cpu);
+    if (num_inputs > 1 && num_jobs != 1) {
+        /* assemble the batch in parallel jobs */
+        masm85_run_jobs (ga, num_inputs, num_jobs, &totals);
+    } else {
+        /* assemble the batch reusing the assembler state. a fatal error ends 
+           only the source it occurs in. */
+        for (i = 0; i < num_inputs; i++) {
+            masm85_result result;
+            if (i > 0) {
+                gat_reset (ga);
+            }
+            masm85_assemble_input (ga, i, &result);
+            masm85_add_result (&totals, &result);
+        }
+    }
+
+    gat_clock (&end_wall, &cpu);
+
+    if (num_inputs > 1) {
+        gat_print (ga, "%u file(s) assembled, %u failed; %u error(s) %u warning(s)", 
+                    num_inputs - totals.num_failed, totals.num_failed, 
+                    totals.err_count, totals.warn_count);
+    }
+    if (totals.cache_hits + totals.cache_misses > 0) {
+        unsigned num_evicted = masm85_cache_evict ();
+        gat_print (ga, "cache: %u hit(s), %u miss(es), %u evicted", 
+                    totals.cache_hits, totals.cache_misses, num_evicted);
+    }
+    if (masm85_get_stats () != MASM85_STATS_NONE && num_inputs > 0) {
+        masm85_print_stats (ga, &totals, num_inputs, end_wall - start_wall, masm85_get_stats ());
     }
     
     gat_cleanup (ga);
+    gat_include_purge ();
+    free (ga);
+    masm85_free_commandline ();
 
-    return exitcode;
+    return totals.exit_code;
 }
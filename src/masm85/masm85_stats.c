@@ -0,0 +1,113 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** masm85_stats.c  -stats report of engine phase timings and counters. */
+#include "masm85.h"
+
+/* phase names in report order */
+static const char *s_phase_names [GAT_NUM_PHASES] = {
+    "open",
+    "pass1",
+    "pass2",
+    "emit",
+    "cleanup"
+};
+
+#define _ms(_ns)        ((double)(_ns) / 1e6)
+#define _num(_n)        ((double)(_n))
+
+/* prints stats in human readable form */
+static void masm85_print_stats_text (gat *ga, const gat_stats *stats, unsigned num_inputs, 
+                                     uint64_t wall_ns) {
+    const double seconds = (double)wall_ns / 1e9;
+    uint64_t total_wall = 0, total_cpu = 0;
+    int i;
+
+    gat_print (ga, "stats: %u file(s), %.0f line(s), %.0f token(s), %.0f source byte(s)", 
+               num_inputs, _num(stats->lines), _num(stats->tokens), _num(stats->source_bytes));
+    gat_print (ga, "  %-18s %12s %12s", "phase", "wall ms", "cpu ms");
+    for (i = 0; i < GAT_NUM_PHASES; i++) {
+        gat_print (ga, "  %-18s %12.3f %12.3f", s_phase_names[i], 
+                   _ms(stats->wall_ns[i]), _ms(stats->cpu_ns[i]));
+        total_wall+= stats->wall_ns[i];
+        total_cpu+= stats->cpu_ns[i];
+    }
+    gat_print (ga, "  %-18s %12.3f %12.3f", "total", _ms(total_wall), _ms(total_cpu));
+
+    gat_print (ga, "  %-18s %12.0f (%.2f probes/lookup)", "symbol lookups", 
+               _num(stats->sym_lookups), 
+               stats->sym_lookups ? _num(stats->sym_probes) / _num(stats->sym_lookups) : 0.0);
+    gat_print (ga, "  %-18s %12.0f", "mnemonic lookups", _num(stats->kw_lookups));
+    gat_print (ga, "  %-18s %12.0f (%.0f line(s))", "macro expansions", 
+               _num(stats->macro_expansions), _num(stats->macro_lines));
+    gat_print (ga, "  %-18s %12.0f (%.0f cached)", "includes", 
+               _num(stats->includes), _num(stats->include_hits));
+    gat_print (ga, "  %-18s %12.0f", "lines skipped", _num(stats->skipped_lines));
+    gat_print (ga, "  %-18s %12.0f", "emitter calls", _num(stats->emit_calls));
+    gat_print (ga, "  %-18s %12.0f", "bytes emitted", _num(stats->emit_bytes));
+    gat_print (ga, "  %-18s %12.0f", "peak heap bytes", _num(stats->peak_heap));
+    gat_print (ga, "  %-18s %12.3f", "batch wall ms", _ms(wall_ns));
+    if (seconds > 0) {
+        gat_print (ga, "  %-18s %12.0f lines/s, %.2f MB/s", "throughput", 
+                   _num(stats->lines) / seconds, 
+                   _num(stats->source_bytes) / (1024.0 * 1024.0) / seconds);
+    }
+}
+
+/* prints stats as a JSON object; one member a line for dashboards to parse */
+static void masm85_print_stats_json (gat *ga, const gat_stats *stats, unsigned num_inputs, 
+                                     uint64_t wall_ns) {
+    int i;
+
+    gat_print (ga, "{");
+    gat_print (ga, "  \"version\": \"%s\",", MASM85_VERSION);
+    gat_print (ga, "  \"files\": %u,", num_inputs);
+    gat_print (ga, "  \"wall_ns\": %.0f,", _num(wall_ns));
+    gat_print (ga, "  \"phases\": {");
+    for (i = 0; i < GAT_NUM_PHASES; i++) {
+        gat_print (ga, "    \"%s\": { \"wall_ns\": %.0f, \"cpu_ns\": %.0f }%s", 
+                   s_phase_names[i], _num(stats->wall_ns[i]), _num(stats->cpu_ns[i]), 
+                   i + 1 < GAT_NUM_PHASES ? "," : "");
+    }
+    gat_print (ga, "  },");
+    gat_print (ga, "  \"source_bytes\": %.0f,", _num(stats->source_bytes));
+    gat_print (ga, "  \"lines\": %.0f,", _num(stats->lines));
+    gat_print (ga, "  \"tokens\": %.0f,", _num(stats->tokens));
+    gat_print (ga, "  \"symbol_lookups\": %.0f,", _num(stats->sym_lookups));
+    gat_print (ga, "  \"symbol_probes\": %.0f,", _num(stats->sym_probes));
+    gat_print (ga, "  \"mnemonic_lookups\": %.0f,", _num(stats->kw_lookups));
+    gat_print (ga, "  \"macro_expansions\": %.0f,", _num(stats->macro_expansions));
+    gat_print (ga, "  \"macro_lines\": %.0f,", _num(stats->macro_lines));
+    gat_print (ga, "  \"includes\": %.0f,", _num(stats->includes));
+    gat_print (ga, "  \"include_hits\": %.0f,", _num(stats->include_hits));
+    gat_print (ga, "  \"skipped_lines\": %.0f,", _num(stats->skipped_lines));
+    gat_print (ga, "  \"emitter_calls\": %.0f,", _num(stats->emit_calls));
+    gat_print (ga, "  \"bytes_emitted\": %.0f,", _num(stats->emit_bytes));
+    gat_print (ga, "  \"peak_heap_bytes\": %.0f", _num(stats->peak_heap));
+    gat_print (ga, "}");
+}
+
+/* prints -stats report of the batch; wall_ns is wall time of the whole batch */
+void masm85_print_stats (gat *ga, const masm85_totals *totals, unsigned num_inputs, 
+                         uint64_t wall_ns, int format) {
+    if (format == MASM85_STATS_JSON) {
+        masm85_print_stats_json (ga, &totals->stats, num_inputs, wall_ns);
+    } else {
+        masm85_print_stats_text (ga, &totals->stats, num_inputs, wall_ns);
+    }
+}
@@ -22,19 +22,26 @@
 #include "gat.h"
 
 /* assemble directive table */
-gat_dirt g_dirt_table [] = {
+const gat_dirt g_dirt_table [] = {
     /*{ token, command, token_index, num_tokens }*/
     { GAT_EQU, "equ", 1, 3}, /* id equ byte|dbl|id|label */
     { GAT_ORG, "org", 0, 2}, /* org dbl */
     { GAT_END, "end", 0, 1}, /* end */
     { GAT_LABEL, ":", 1, 2 }, /* id: */
+    { GAT_MACRO, "macro", 1, 0 }, /* id macro [id {, id}]; 0 takes any number of tokens */
+    { GAT_ENDM, "endm", 0, 1 }, /* endm */
+    { GAT_INCLUDE, "include", 0, 2 }, /* include "path" */
+    { GAT_IF, "if", 0, 0 }, /* if byte|dbl|id */
+    { GAT_IFDEF, "ifdef", 0, 0 }, /* ifdef id */
+    { GAT_ELSE, "else", 0, 0 }, /* else */
+    { GAT_ENDIF, "endif", 0, 0 }, /* endif */
 };
 
 /* Length of directive table. */
-const int g_len_dirt_table = sizeof(g_dirt_table) / sizeof(g_dirt_table[0]);
+const unsigned g_len_dirt_table = sizeof(g_dirt_table) / sizeof(g_dirt_table[0]);
 
 /* instruction table */
-gat_instr g_instr_table [] =
+const gat_instr g_instr_table [] =
 {
     /*{ mnemonic, opcode, num_operands, type_operands[3], type_options[3] }*/
     { "aci", 0xCE, 1, { GAT_OPRND_BYTE }, { 0 } },
@@ -134,4 +141,4 @@ gat_instr g_instr_table [] =
 };
 
 /* Length of instruction table. */
-const int g_len_instr_table = sizeof(g_instr_table) / sizeof(g_instr_table[0]);
+const unsigned g_len_instr_table = sizeof(g_instr_table) / sizeof(g_instr_table[0]);
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** bench_gen.c  generates seeded, reproducible 8085 sources for the benchmark suite. 
+    every instruction in masm85_table.c is emitted once, then instructions are picked 
+    at random with labels, EQUs, forward references and ORG jumps mixed in. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gat.h"
+
+/* externs */
+extern const gat_instr g_instr_table[];
+extern const unsigned g_len_instr_table;
+
+/* defaults; percentages are of all lines except fwd which is of word operands */
+#define BENCH_DEF_SEED              8085
+#define BENCH_DEF_LABEL_PCT         5
+#define BENCH_DEF_EQU_PCT           2
+#define BENCH_DEF_FWD_PCT           10
+#define BENCH_DEF_ORG_EVERY         1000
+
+/* code stays below this address */
+#define BENCH_ORG_LIMIT             0xF000
+/* ORG blocks of the first sweep through the code space */
+#define BENCH_MAX_BLOCKS            0x10000
+/* forward references reach up to this many labels ahead */
+#define BENCH_MAX_FWD               8
+
+typedef struct _bench_gen {
+    uint64_t rng;
+    unsigned label_pct;
+    unsigned equ_pct;
+    unsigned fwd_pct;
+    unsigned org_every;
+    unsigned num_lines;         /* lines written */
+    unsigned org_lines;         /* lines since last org */
+    unsigned num_labels;        /* labels defined */
+    unsigned max_label;         /* labels referenced are below this */
+    unsigned num_bytes;         /* byte EQUs defined */
+    unsigned num_words;         /* word EQUs defined */
+    unsigned offset;            /* code offset */
+    unsigned end;               /* end of the current ORG block */
+    unsigned num_blocks;        /* ORG blocks laid out by the first sweep */
+    unsigned block;             /* block written over after the first sweep */
+    int wrapped;                /* is code past the first sweep? */
+}bench_gen;
+
+/* a block of the first sweep, from start to the end of its code */
+typedef struct _bench_block {
+    unsigned start;
+    unsigned end;
+}bench_block;
+
+static bench_block s_blocks[BENCH_MAX_BLOCKS];
+
+/* xorshift64* generator; same seed gives the same source on every platform */
+static uint32_t bench_rand (bench_gen *bg) {
+    bg->rng ^= bg->rng >> 12;
+    bg->rng ^= bg->rng << 25;
+    bg->rng ^= bg->rng >> 27;
+    return (uint32_t)((bg->rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+#define bench_pick(_bg,_n) (bench_rand(_bg) % (_n))
+
+static void bench_line (bench_gen *bg, const char *text) {
+    puts (text);
+    ++bg->num_lines;
+    ++bg->org_lines;
+}
+
+/* starts the next ORG block. the first sweep places blocks in ascending order 
+   with a gap after each, so they never overlap. a source with more code than 
+   fits then writes over the blocks of the first sweep again, never into the 
+   gaps, so all of its overlapping code is a single stretch. */
+static void bench_org (bench_gen *bg) {
+    char line[32];
+    unsigned i;
+
+    if (!bg->wrapped) {
+        if (bg->num_blocks > 0) {
+            s_blocks[bg->num_blocks - 1].end = bg->offset;
+            bg->offset+= bench_pick (bg, 0x40);
+        } else {
+            bg->offset = 0x100 + bench_pick (bg, 0x100);
+        }
+        if (bg->offset + 3 <= BENCH_ORG_LIMIT && bg->num_blocks < BENCH_MAX_BLOCKS) {
+            s_blocks[bg->num_blocks].start = bg->offset;
+            ++bg->num_blocks;
+            bg->end = BENCH_ORG_LIMIT;
+        } else {
+            bg->wrapped = 1;
+            bg->block = bg->num_blocks - 1;
+        }
+    }
+    if (bg->wrapped) {
+        /* next block with room for an instruction */
+        for (i = 0; i < bg->num_blocks; i++) {
+            bg->block = (bg->block + 1) % bg->num_blocks;
+            if (s_blocks[bg->block].end - s_blocks[bg->block].start >= 3) {
+                break;
+            }
+        }
+        bg->offset = s_blocks[bg->block].start;
+        bg->end = s_blocks[bg->block].end;
+    }
+    sprintf (line, "org 0%04xh", bg->offset);
+    bench_line (bg, line);
+    bg->org_lines = 0;
+}
+
+static void bench_label (bench_gen *bg) {
+    char line[32];
+    sprintf (line, "L%u:", bg->num_labels++);
+    if (bg->max_label < bg->num_labels) {
+        bg->max_label = bg->num_labels;
+    }
+    bench_line (bg, line);
+}
+
+static void bench_equ (bench_gen *bg) {
+    char line[32];
+    if (bench_pick (bg, 2)) {
+        sprintf (line, "B%u equ 0%02xh", bg->num_bytes++, bench_pick (bg, 0x100));
+    } else {
+        sprintf (line, "W%u equ 0x%04x", bg->num_words++, 0x100 + bench_pick (bg, 0xFF00));
+    }
+    bench_line (bg, line);
+}
+
+/* byte literal in one of the number formats or a byte EQU */
+static char *bench_byte (bench_gen *bg, char *out) {
+    unsigned value = bench_pick (bg, 0x100);
+    if (bg->num_bytes && !bench_pick (bg, 4)) {
+        sprintf (out, "B%u", bench_pick (bg, bg->num_bytes));
+        return out;
+    }
+    switch (bench_pick (bg, 3)) {
+    case 0: sprintf (out, "%u", value); break;
+    case 1: sprintf (out, "0x%02x", value); break;
+    default: sprintf (out, "0%02xh", value); break;
+    }
+    return out;
+}
+
+/* word literal, word EQU, label defined earlier or a forward reference */
+static char *bench_word (bench_gen *bg, char *out) {
+    unsigned value = 0x100 + bench_pick (bg, 0xFF00);
+    if (bench_pick (bg, 100) < bg->fwd_pct) {
+        unsigned label = bg->num_labels + bench_pick (bg, BENCH_MAX_FWD);
+        if (bg->max_label <= label) {
+            bg->max_label = label + 1;
+        }
+        sprintf (out, "L%u", label);
+        return out;
+    }
+    switch (bench_pick (bg, 5)) {
+    case 0: 
+        if (bg->num_labels) {
+            sprintf (out, "L%u", bench_pick (bg, bg->num_labels));
+            return out;
+        }
+        break;
+    case 1:
+        if (bg->num_words) {
+            sprintf (out, "W%u", bench_pick (bg, bg->num_words));
+            return out;
+        }
+        break;
+    case 2: sprintf (out, "%u", value); return out;
+    case 3: sprintf (out, "0x%04x", value); return out;
+    }
+    sprintf (out, "0%04xh", value);
+    return out;
+}
+
+/* register pair accepted by the masm85 filter for the mnemonic */
+static const char *bench_reg16 (bench_gen *bg, const char *mnemonic) {
+    static const char *s_stack[] = { "b", "d", "h", "psw" };
+    static const char *s_mem[] = { "b", "d" };
+    static const char *s_pair[] = { "b", "d", "h", "sp" };
+
+    if (!strcmp (mnemonic, "push") || !strcmp (mnemonic, "pop")) {
+        return s_stack[bench_pick (bg, 4)];
+    }
+    if (!strcmp (mnemonic, "ldax") || !strcmp (mnemonic, "stax")) {
+        return s_mem[bench_pick (bg, 2)];
+    }
+    return s_pair[bench_pick (bg, 4)];
+}
+
+static void bench_instr (bench_gen *bg, const gat_instr *instr) {
+    static const char s_reg8[] = "abcdehlm";
+    char line[128], operand[32];
+    char *p = line;
+    unsigned i, size = 1;
+    int reg8_m = 0;
+
+    if (bg->offset + 3 > bg->end || (bg->org_every && bg->org_lines >= bg->org_every)) {
+        bench_org (bg);
+    }
+
+    p += sprintf (p, bench_pick (bg, 2) ? "    " : "\t");
+    if (!bench_pick (bg, 8)) {
+        for (i = 0; instr->mnemonic[i]; i++) {
+            *p++ = (char)(instr->mnemonic[i] - 'a' + 'A');
+        }
+    } else {
+        p += sprintf (p, "%s", instr->mnemonic);
+    }
+
+    for (i = 0; i < instr->num_tokens; i++) {
+        if (instr->type_operands[i] != GAT_OPRND_SYMBOL) {
+            *p++ = ' ';
+        }
+        switch (instr->type_operands[i]) {
+        case GAT_OPRND_REG8:
+            /* mov m, m is not an instruction */
+            operand[0] = s_reg8[bench_pick (bg, reg8_m ? 7 : 8)];
+            operand[1] = '\0';
+            reg8_m = operand[0] == 'm';
+            p += sprintf (p, "%s", operand);
+            break;
+        case GAT_OPRND_REG16:
+            p += sprintf (p, "%s", bench_reg16 (bg, instr->mnemonic));
+            break;
+        case GAT_OPRND_BYTE:
+            if (instr->type_options[i]) {
+                p += sprintf (p, "%u", bench_pick (bg, 8));
+            } else {
+                p += sprintf (p, "%s", bench_byte (bg, operand));
+                size += 1;
+            }
+            break;
+        case GAT_OPRND_DBL:
+            p += sprintf (p, "%s", bench_word (bg, operand));
+            size += 2;
+            break;
+        case GAT_OPRND_SYMBOL:
+            *p++ = (char)instr->type_options[i];
+            break;
+        }
+    }
+
+    if (!bench_pick (bg, 32)) {
+        p += sprintf (p, "   ; %s", instr->mnemonic);
+    }
+    *p = '\0';
+
+    bench_line (bg, line);
+    bg->offset += size;
+}
+
+static int bench_arg (const char *arg, const char *name, unsigned *value) {
+    size_t length = strlen (name);
+    if (strncmp (arg, name, length) || !arg[length]) {
+        return 0;
+    }
+    *value = (unsigned)strtoul (arg + length, NULL, 10);
+    return 1;
+}
+
+int main (int argc, char *argv[]) {
+    bench_gen bg;
+    unsigned lines, seed = BENCH_DEF_SEED;
+    unsigned pick;
+    int i;
+
+    if (argc < 2 || !(lines = (unsigned)strtoul (argv[1], NULL, 10))) {
+        fprintf (stderr, "usage: bench_gen <lines> [-seed<n>] [-label<%%>] [-equ<%%>] "
+                         "[-fwd<%%>] [-org<lines>]\n");
+        return 1;
+    }
+
+    memset (&bg, 0, sizeof(bg));
+    bg.label_pct = BENCH_DEF_LABEL_PCT;
+    bg.equ_pct = BENCH_DEF_EQU_PCT;
+    bg.fwd_pct = BENCH_DEF_FWD_PCT;
+    bg.org_every = BENCH_DEF_ORG_EVERY;
+
+    for (i = 2; i < argc; i++) {
+        if (!bench_arg (argv[i], "-seed", &seed) &&
+            !bench_arg (argv[i], "-label", &bg.label_pct) &&
+            !bench_arg (argv[i], "-equ", &bg.equ_pct) &&
+            !bench_arg (argv[i], "-fwd", &bg.fwd_pct) &&
+            !bench_arg (argv[i], "-org", &bg.org_every)) {
+            fprintf (stderr, "bench_gen: invalid option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (bg.label_pct + bg.equ_pct > 100 || bg.fwd_pct > 100) {
+        fprintf (stderr, "bench_gen: densities out of range\n");
+        return 1;
+    }
+
+    /* a zero state would stay zero */
+    bg.rng = ((uint64_t)seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+
+    printf ("; bench_gen %u -seed%u -label%u -equ%u -fwd%u -org%u\n", lines, seed, 
+            bg.label_pct, bg.equ_pct, bg.fwd_pct, bg.org_every);
+    ++bg.num_lines;
+    bench_org (&bg);
+
+    /* every instruction once, then at random */
+    for (i = 0; i < (int)g_len_instr_table && bg.num_lines < lines; i++) {
+        bench_instr (&bg, g_instr_table + i);
+    }
+    while (bg.num_lines < lines) {
+        pick = bench_pick (&bg, 100);
+        if (pick < bg.label_pct) {
+            bench_label (&bg);
+        } else if (pick < bg.label_pct + bg.equ_pct) {
+            bench_equ (&bg);
+        } else if (!bench_pick (&bg, 64)) {
+            bench_line (&bg, "");
+        } else {
+            bench_instr (&bg, g_instr_table + bench_pick (&bg, g_len_instr_table));
+        }
+    }
+
+    /* define labels still pending from forward references */
+    while (bg.num_labels < bg.max_label) {
+        bench_label (&bg);
+    }
+    bench_line (&bg, "end");
+    return 0;
+}
@@ -0,0 +1,390 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** bench_kernels.c  times gat kernels in isolation over the token streams of a source 
+    and reports ns/op and heap allocations/op. the source is assembled once with the 
+    single pass engine; its lines, tokens, symbols and generated code are the inputs. 
+    built with BENCH_COUNT_ALLOCS, allocator calls are counted through ld --wrap. */
+#include <stdio.h>
+#include <stdlib.h>
+#include "gat.h"
+#include "gat_err.h"
+
+/* externs */
+extern const gat_arch masm85_arch;
+extern const gat_dirt g_dirt_table[];
+extern const gat_instr g_instr_table[];
+extern const unsigned g_len_dirt_table;
+extern const unsigned g_len_instr_table;
+extern const gat_kwtable g_kw_table;
+extern void masm85_hex_emitter (gat *ga, gat_io *io, gat_emitter_state state);
+extern void masm85_bin_emitter (gat *ga, gat_io *io, gat_emitter_state state);
+extern void masm85_dbg_emitter (gat *ga, gat_io *io, gat_emitter_state state);
+
+#ifdef WIN32
+#define BENCH_NULL_DEVICE           "NUL"
+#else
+#define BENCH_NULL_DEVICE           "/dev/null"
+#endif
+
+/* each kernel runs over its whole input until this much time has passed */
+#define BENCH_DEF_MIN_MS            200
+
+/* allocator calls made so far */
+static unsigned long s_num_allocs;
+
+#ifdef BENCH_COUNT_ALLOCS
+void *__real_malloc (size_t size);
+void *__real_calloc (size_t count, size_t size);
+void *__real_realloc (void *ptr, size_t size);
+
+void *__wrap_malloc (size_t size) {
+    ++s_num_allocs;
+    return __real_malloc (size);
+}
+
+void *__wrap_calloc (size_t count, size_t size) {
+    ++s_num_allocs;
+    return __real_calloc (count, size);
+}
+
+void *__wrap_realloc (void *ptr, size_t size) {
+    ++s_num_allocs;
+    return __real_realloc (ptr, size);
+}
+#endif
+
+/* a string; either a view into source text or a null terminated copy */
+typedef struct _bench_str {
+    const char *text;
+    size_t length;
+}bench_str;
+
+typedef struct _bench_set {
+    bench_str *items;
+    unsigned count;
+    unsigned max;
+}bench_set;
+
+/* generated code of a line or an org */
+typedef struct _bench_code {
+    uint8_t bin[3];
+    uint8_t bin_size;           /* 0 for an org */
+    uint16_t org;
+    unsigned line_num;
+}bench_code;
+
+static bench_set s_lines;       /* source lines */
+static bench_set s_heads;       /* first token of each line */
+static bench_set s_words;       /* all word tokens */
+static bench_set s_nums;        /* number tokens */
+static bench_set s_symbols;     /* symbol operands of instructions */
+static bench_code *s_codes;
+static unsigned s_num_codes;
+static unsigned s_num_emits;
+static unsigned s_image_bytes;  /* bytes written in the memory image */
+
+/* results are summed here so kernels calls are not optimized away */
+static volatile uint32_t s_sink;
+
+static void bench_add (bench_set *set, const char *text, size_t length, int copy) {
+    bench_str *item;
+    if (set->count == set->max) {
+        set->max = set->max ? set->max * 2 : 1024;
+        set->items = (bench_str *)realloc (set->items, set->max * sizeof(bench_str));
+    }
+    item = set->items + set->count++;
+    item->length = length;
+    item->text = text;
+    if (copy) {
+        char *temp = (char *)malloc (length + 1);
+        memcpy (temp, text, length);
+        temp[length] = '\0';
+        item->text = temp;
+    }
+}
+
+static void bench_add_code (const gat_line *line, uint16_t org) {
+    bench_code *code;
+    if ((s_num_codes & 1023) == 0) {
+        s_codes = (bench_code *)realloc (s_codes, (s_num_codes + 1024) * sizeof(bench_code));
+    }
+    code = s_codes + s_num_codes++;
+    memcpy (code->bin, line->bin, sizeof(code->bin));
+    code->bin_size = line->bin_size;
+    code->org = org;
+    code->line_num = line->line_num;
+    s_num_emits+= line->bin_size > 0;
+}
+
+/* collects kernel inputs from the assembled source */
+static void bench_collect (gat *ga) {
+    uint32_t start = 0, length;
+    unsigned i;
+    int instr;
+
+    gat_rewind_source (ga);
+    ga->line_num = 0;
+    while (gat_read_line (ga)) {
+        bench_add (&s_lines, ga->line, ga->line_len, 0);
+        gat_tokenize (ga);
+        if (ga->num_tokens == 0) {
+            continue;
+        }
+        bench_add (&s_heads, ga->arr_raw_tokens[0].string, ga->arr_raw_tokens[0].length, 1);
+        instr = gat_search_instr (ga, ga->arr_raw_tokens[0].string, ga->arr_raw_tokens[0].length);
+
+        for (i = 0; i < ga->num_tokens; i++) {
+            const gat_token *token = ga->arr_raw_tokens + i;
+            if (token->type != GAT_TOK_WORD) {
+                continue;
+            }
+            bench_add (&s_words, token->string, token->length, 1);
+            if (token->num_width != GAT_NUMW_NONE) {
+                bench_add (&s_nums, token->string, token->length, 1);
+            } else if (i > 0 && instr >= 0) {
+                const char *text = s_words.items[s_words.count - 1].text;
+                if (!ga->arch->is_reg8 (text) && !ga->arch->is_reg16 (text)) {
+                    bench_add (&s_symbols, token->string, token->length, 1);
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < ga->ir.num_lines; i++) {
+        const gat_line *line = ga->ir.lines + i;
+        if (line->kind == GAT_LINE_ORG) {
+            gat_ir_load_line (ga, line);
+            if (gat_parse_org (ga)) {
+                bench_add_code (line, (uint16_t)ga->org);
+                s_codes[s_num_codes - 1].bin_size = 0;
+            }
+        } else if (line->bin_size > 0) {
+            bench_add_code (line, 0);
+        }
+    }
+
+    /* the engine left the code in the memory image */
+    for (; gat_image_next_run (ga->image, &start, &length); start+= length) {
+        s_image_bytes+= length;
+    }
+}
+
+/* kernels; each makes one run over its input and returns the number of ops */
+
+static unsigned bench_tokenize (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_lines.count; i++) {
+        ga->line = s_lines.items[i].text;
+        ga->line_len = s_lines.items[i].length;
+        s_sink+= (uint32_t)gat_tokenize (ga);
+    }
+    return s_lines.count;
+}
+
+static unsigned bench_is_id (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_words.count; i++) {
+        s_sink+= gat_is_id (s_words.items[i].text);
+    }
+    return s_words.count;
+}
+
+static unsigned bench_is_num (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_words.count; i++) {
+        s_sink+= gat_is_num (s_words.items[i].text);
+    }
+    return s_words.count;
+}
+
+static unsigned bench_cnum (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_nums.count; i++) {
+        s_sink+= gat_cnum (s_nums.items[i].text);
+    }
+    return s_nums.count;
+}
+
+static unsigned bench_search_instr (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_heads.count; i++) {
+        s_sink+= gat_search_instr (ga, s_heads.items[i].text, s_heads.items[i].length);
+    }
+    return s_heads.count;
+}
+
+static unsigned bench_search_id (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_symbols.count; i++) {
+        s_sink+= gat_search_id (ga, s_symbols.items[i].text);
+    }
+    return s_symbols.count;
+}
+
+static unsigned bench_search_label (gat *ga) {
+    unsigned i;
+    for (i = 0; i < s_symbols.count; i++) {
+        s_sink+= gat_search_label (ga, s_symbols.items[i].text);
+    }
+    return s_symbols.count;
+}
+
+/* replays the generated code and orgs into the memory image */
+static unsigned bench_emit (gat *ga) {
+    unsigned i;
+
+    gat_image_begin (ga);
+    ga->org = ga->offset = 0;
+    for (i = 0; i < s_num_codes; i++) {
+        const bench_code *code = s_codes + i;
+        if (code->bin_size == 0) {
+            ga->org = ga->offset = code->org;
+        } else {
+            memcpy (ga->bin, code->bin, code->bin_size);
+            ga->bin_size = code->bin_size;
+            ga->line_num = code->line_num;
+            gat_emit (ga);
+        }
+    }
+    return s_num_emits;
+}
+
+/* serializes the memory image through an emitter into the null device; one op 
+   is one image byte */
+static unsigned bench_serialize (gat *ga, gat_emitter emitter) {
+    gat_io io;
+
+    memset (&io, 0, sizeof(io));
+    io.fp = fopen (BENCH_NULL_DEVICE, "wb");
+    if (io.fp == NULL) {
+        gat_fatal_error (ga, GAT_ERR_FILE_OPEN, "error opening %s", BENCH_NULL_DEVICE);
+    }
+    emitter (ga, &io, GAT_EMIT_BEGIN_ASSEMBLY);
+    emitter (ga, &io, GAT_EMIT_END_ASSEMBLY);
+    fclose (io.fp);
+    return s_image_bytes;
+}
+
+static unsigned bench_emit_hex (gat *ga) {
+    return bench_serialize (ga, masm85_hex_emitter);
+}
+
+static unsigned bench_emit_bin (gat *ga) {
+    return bench_serialize (ga, masm85_bin_emitter);
+}
+
+static unsigned bench_emit_dbg (gat *ga) {
+    return bench_serialize (ga, masm85_dbg_emitter);
+}
+
+typedef struct _bench_kernel {
+    const char *name;
+    const char *unit;           /* what one op is */
+    unsigned (*run) (gat *ga);
+}bench_kernel;
+
+/* emitters serialize the image gat_emit leaves */
+static const bench_kernel s_kernels[] = {
+    { "gat_tokenize", "line", bench_tokenize },
+    { "gat_is_id", "word", bench_is_id },
+    { "gat_is_num", "word", bench_is_num },
+    { "gat_cnum", "number", bench_cnum },
+    { "gat_search_instr", "line", bench_search_instr },
+    { "gat_search_id", "symbol", bench_search_id },
+    { "gat_search_label", "symbol", bench_search_label },
+    { "gat_emit", "instr", bench_emit },
+    { "masm85_hex_emitter", "byte", bench_emit_hex },
+    { "masm85_bin_emitter", "byte", bench_emit_bin },
+    { "masm85_dbg_emitter", "byte", bench_emit_dbg },
+};
+
+static void bench_time (gat *ga, const bench_kernel *kernel, uint64_t min_ns) {
+    uint64_t start, end, cpu, ops = 0;
+    unsigned long allocs;
+
+    /* warm up caches and lazily allocated state */
+    if (kernel->run (ga) == 0) {
+        printf ("%-20s %-7s %12s\n", kernel->name, kernel->unit, "no input");
+        return;
+    }
+
+    allocs = s_num_allocs;
+    gat_clock (&start, &cpu);
+    do {
+        ops+= kernel->run (ga);
+        gat_clock (&end, &cpu);
+    } while (end - start < min_ns);
+    allocs = s_num_allocs - allocs;
+
+    printf ("%-20s %-7s %12.0f %10.2f", kernel->name, kernel->unit, (double)ops, 
+            (double)(end - start) / ops);
+#ifdef BENCH_COUNT_ALLOCS
+    printf (" %12.4f\n", (double)allocs / ops);
+#else
+    printf (" %12s\n", "-");
+#endif
+}
+
+int main (int argc, char *argv[]) {
+    char output_path[GAT_MAX_PATH];
+    unsigned min_ms = BENCH_DEF_MIN_MS, i;
+    gat *ga;
+
+    if (argc < 2 || strlen (argv[1]) + 5 > GAT_MAX_PATH) {
+        fprintf (stderr, "usage: bench_kernels <source> [-ms<min-time-per-kernel>]\n");
+        return 1;
+    }
+    if (argc > 2 && !strncmp (argv[2], "-ms", 3) && atoi (argv[2] + 3) > 0) {
+        min_ms = (unsigned)atoi (argv[2] + 3);
+    }
+
+    ga = (gat *)malloc (sizeof(gat));
+    if (ga == NULL) {
+        fprintf (stderr, "out of memory\n");
+        return GAT_ERR_OUT_OF_MEMORY;
+    }
+    gat_init (ga, &masm85_arch, g_dirt_table, g_len_dirt_table, g_instr_table, g_len_instr_table);
+    gat_set_keywords (ga, &g_kw_table);
+    gat_set_engine (ga, GAT_ENGINE_SINGLE_PASS);
+
+    /* assemble once; symbols, IR and source text stay until gat_close */
+    strcpy (output_path, argv[1]);
+    gat_attach_extension (ga, output_path, ".hex");
+    gat_attach_io (ga, "rt", argv[1], NULL);
+    gat_attach_io (ga, "wt", output_path, masm85_hex_emitter);
+    if (gat_engine (ga) != 0) {
+        fprintf (stderr, "bench_kernels: %s does not assemble cleanly\n", argv[1]);
+        return 1;
+    }
+    bench_collect (ga);
+
+    printf ("%s: %u lines, %u words, %u numbers, %u symbols, %u instructions, %u image bytes\n", 
+            argv[1], s_lines.count, s_words.count, s_nums.count, s_symbols.count, s_num_emits, 
+            s_image_bytes);
+    printf ("%-20s %-7s %12s %10s %12s\n", "kernel", "op", "ops", "ns/op", "allocs/op");
+    for (i = 0; i < sizeof(s_kernels) / sizeof(s_kernels[0]); i++) {
+        bench_time (ga, s_kernels + i, (uint64_t)min_ms * 1000000);
+    }
+
+    gat_close (ga);
+    gat_kill_file (ga, output_path);
+    gat_cleanup (ga);
+    free (ga);
+    return 0;
+}
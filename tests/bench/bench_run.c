@@ -0,0 +1,263 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** bench_run.c  runs masm85 over the benchmark sources in -hex and -85 modes and 
+    reports lines/sec, MB/sec and peak RSS against a stored baseline. POSIX only; 
+    peak RSS of each masm85 run is read back with wait4(). */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define BENCH_MAX_RESULTS           256
+#define BENCH_MAX_NAME              64
+#define BENCH_DEF_REPS              5
+#define BENCH_DEF_TOL               15      /* percent */
+
+typedef struct _bench_result {
+    char name[BENCH_MAX_NAME];
+    char mode[4];
+    double lines_per_sec;
+    double mb_per_sec;
+    long rss_kb;
+}bench_result;
+
+static bench_result s_baseline[BENCH_MAX_RESULTS];
+static unsigned s_num_baseline;
+static bench_result s_results[BENCH_MAX_RESULTS];
+static unsigned s_num_results;
+
+/* source name without directory and extension keys the baseline */
+static void bench_name (const char *path, char *name) {
+    const char *base = strrchr (path, '/');
+    char *ext;
+    strncpy (name, base ? base + 1 : path, BENCH_MAX_NAME - 1);
+    name[BENCH_MAX_NAME - 1] = '\0';
+    if ((ext = strrchr (name, '.')) != NULL) {
+        *ext = '\0';
+    }
+}
+
+static int bench_measure_source (const char *path, unsigned long *lines, unsigned long *bytes) {
+    char buff[65536];
+    size_t n, i;
+    FILE *fp = fopen (path, "rb");
+    if (!fp) {
+        return 0;
+    }
+    *lines = *bytes = 0;
+    while ((n = fread (buff, 1, sizeof(buff), fp)) > 0) {
+        for (i = 0; i < n; i++) {
+            *lines += buff[i] == '\n';
+        }
+        *bytes += n;
+    }
+    fclose (fp);
+    return 1;
+}
+
+/* runs masm85 once; returns wall seconds or a negative value if it failed */
+static double bench_exec (const char *masm85, const char *path, const char *mode, long *rss_kb) {
+    struct timeval start, end;
+    struct rusage usage;
+    int status, fd;
+    pid_t pid;
+
+    gettimeofday (&start, NULL);
+    pid = fork ();
+    if (pid == 0) {
+        fd = open ("/dev/null", O_WRONLY);
+        dup2 (fd, 1);
+        dup2 (fd, 2);
+        execl (masm85, masm85, path, mode, (char *)NULL);
+        _exit (127);
+    }
+    if (pid < 0 || wait4 (pid, &status, 0, &usage) != pid) {
+        return -1.0;
+    }
+    gettimeofday (&end, NULL);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1.0;
+    }
+#if defined(__MACH__) || defined(__APPLE__)
+    *rss_kb = usage.ru_maxrss / 1024;
+#else
+    *rss_kb = usage.ru_maxrss;
+#endif
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+static const bench_result *bench_find (const char *name, const char *mode) {
+    unsigned i;
+    for (i = 0; i < s_num_baseline; i++) {
+        if (!strcmp (s_baseline[i].name, name) && !strcmp (s_baseline[i].mode, mode)) {
+            return s_baseline + i;
+        }
+    }
+    return NULL;
+}
+
+static int bench_load_baseline (const char *path) {
+    char line[256];
+    bench_result *r;
+    FILE *fp = fopen (path, "r");
+    if (!fp) {
+        return 0;
+    }
+    while (fgets (line, sizeof(line), fp) && s_num_baseline < BENCH_MAX_RESULTS) {
+        r = s_baseline + s_num_baseline;
+        if (line[0] != '#' && sscanf (line, "%63s %3s %lf %lf %ld", r->name, r->mode, 
+                                      &r->lines_per_sec, &r->mb_per_sec, &r->rss_kb) == 5) {
+            ++s_num_baseline;
+        }
+    }
+    fclose (fp);
+    return 1;
+}
+
+static int bench_save_baseline (const char *path) {
+    unsigned i;
+    FILE *fp = fopen (path, "w");
+    if (!fp) {
+        return 0;
+    }
+    fprintf (fp, "# masm85 bench baseline: source mode lines/sec MB/sec peak-rss-KB\n");
+    for (i = 0; i < s_num_results; i++) {
+        fprintf (fp, "%s %s %.0f %.2f %ld\n", s_results[i].name, s_results[i].mode, 
+                 s_results[i].lines_per_sec, s_results[i].mb_per_sec, s_results[i].rss_kb);
+    }
+    fclose (fp);
+    return 1;
+}
+
+int main (int argc, char *argv[]) {
+    static const char *s_modes[] = { "-hex", "-85" };
+    const char *masm85 = NULL, *baseline = NULL;
+    const bench_result *base;
+    bench_result *r;
+    unsigned long lines, bytes;
+    unsigned reps = BENCH_DEF_REPS, tol = BENCH_DEF_TOL;
+    unsigned m, k, num_slower = 0;
+    int update = 0, failed = 0, i;
+    double secs, best;
+    long rss_kb, best_rss;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp (argv[i], "-update")) {
+            update = 1;
+        } else if (!strncmp (argv[i], "-reps", 5) && atoi (argv[i] + 5) > 0) {
+            reps = (unsigned)atoi (argv[i] + 5);
+        } else if (!strncmp (argv[i], "-tol", 4) && argv[i][4]) {
+            tol = (unsigned)atoi (argv[i] + 4);
+        } else {
+            break;
+        }
+    }
+    if (argc - i < 3) {
+        fprintf (stderr, "usage: bench_run [-update] [-reps<n>] [-tol<%%>] "
+                         "<masm85> <baseline> <source>...\n");
+        return 1;
+    }
+    masm85 = argv[i++];
+    baseline = argv[i++];
+
+    if (!bench_load_baseline (baseline)) {
+        update = 1;
+    }
+
+    printf ("%-16s %-4s %10s %8s %9s %12s %8s %9s  %s\n", "source", "mode", "lines", "MB", 
+            "best ms", "lines/sec", "MB/sec", "rss KB", "vs baseline");
+
+    for (; i < argc; i++) {
+        if (!bench_measure_source (argv[i], &lines, &bytes)) {
+            fprintf (stderr, "bench_run: cannot read %s\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+        for (m = 0; m < 2 && s_num_results < BENCH_MAX_RESULTS; m++) {
+            r = s_results + s_num_results;
+            bench_name (argv[i], r->name);
+            strcpy (r->mode, s_modes[m] + 1);
+
+            /* best wall time of reps; peak RSS is the largest seen */
+            best = -1.0;
+            best_rss = 0;
+            for (k = 0; k < reps; k++) {
+                secs = bench_exec (masm85, argv[i], s_modes[m], &rss_kb);
+                if (secs < 0) {
+                    break;
+                }
+                if (best < 0 || secs < best) {
+                    best = secs;
+                }
+                if (rss_kb > best_rss) {
+                    best_rss = rss_kb;
+                }
+            }
+            if (best < 0) {
+                printf ("%-16s %-4s masm85 failed\n", r->name, r->mode);
+                failed = 1;
+                continue;
+            }
+            if (best < 1e-6) {
+                best = 1e-6;
+            }
+
+            r->lines_per_sec = lines / best;
+            r->mb_per_sec = bytes / (1024.0 * 1024.0) / best;
+            r->rss_kb = best_rss;
+            ++s_num_results;
+
+            printf ("%-16s %-4s %10lu %8.2f %9.2f %12.0f %8.2f %9ld", r->name, r->mode, lines, 
+                    bytes / (1024.0 * 1024.0), best * 1000.0, r->lines_per_sec, r->mb_per_sec, 
+                    r->rss_kb);
+
+            base = bench_find (r->name, r->mode);
+            if (base && base->lines_per_sec > 0 && base->rss_kb > 0) {
+                double speed = (r->lines_per_sec / base->lines_per_sec - 1.0) * 100.0;
+                double rss = ((double)r->rss_kb / base->rss_kb - 1.0) * 100.0;
+                printf ("  %+6.1f%% speed %+6.1f%% rss", speed, rss);
+                if (speed < -(double)tol || rss > (double)tol) {
+                    printf ("  <- regressed");
+                    ++num_slower;
+                }
+            } else {
+                printf ("  (no baseline)");
+            }
+            printf ("\n");
+        }
+    }
+
+    if (num_slower) {
+        printf ("%u result(s) regressed beyond %u%%\n", num_slower, tol);
+    }
+    if (update && !failed) {
+        if (!bench_save_baseline (baseline)) {
+            fprintf (stderr, "bench_run: cannot write %s\n", baseline);
+            return 1;
+        }
+        printf ("baseline written to %s\n", baseline);
+    }
+    return failed;
+}
@@ -0,0 +1,7 @@
+; first source of the batch run, given on the command line
+        org 0100h
+start:
+        lxi h, 2000h
+        mvi m, 11h
+        jmp start
+        end
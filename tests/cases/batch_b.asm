@@ -0,0 +1,7 @@
+; last source of the batch run; it defines start too, as each source gets 
+; its own symbols
+        org 0200h
+start:
+        mvi a, 22h
+        jmp start
+        end
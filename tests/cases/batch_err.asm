@@ -0,0 +1,6 @@
+; a source that fails in the middle of the batch; its output is removed and 
+; the sources after it are still assembled
+        org 0300h
+        mvi a, 33h
+        foo
+        end
@@ -0,0 +1,27 @@
+; nested blocks inside a false block are skipped whatever their values
+debug   equ 0
+level   equ 2
+
+        org 0
+        if debug
+        if level
+        call trace
+        else
+        nop
+        endif
+        mvi a, 1
+        else
+        if level - 2
+        mvi a, 2
+        else
+        mvi a, 3
+        ifdef level
+        mvi b, 4
+        endif
+        ifdef trace
+        mvi b, 5
+        endif
+        endif
+        endif
+        hlt
+        end
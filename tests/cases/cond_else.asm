@@ -0,0 +1,10 @@
+; a second ELSE in one block is an error
+        if 1
+        mvi a, 1
+        else
+        mvi a, 2
+        else
+        mvi a, 3
+        endif
+        hlt
+        end
@@ -0,0 +1,8 @@
+; an IF without ENDIF is reported at its IF line, and an ENDIF without IF 
+; where it stands
+        endif
+        nop
+        if 1
+        mvi a, 1
+        hlt
+        end
@@ -0,0 +1,29 @@
+; precedence from the highest: unary, * / %, + -, << >>, &, ^, |
+base    equ 1000h
+count   equ 3
+neg     equ -1
+va      equ 3
+vb      equ 5
+vc      equ 10
+
+        org 0
+        mvi a, 2+3*4
+        mvi a, (2+3)*4
+        mvi a, 20-6/2
+        mvi a, 1+2<<3
+        mvi a, 0F0h|0Fh&3
+        mvi a, 6^3&5
+        mvi a, 17%5*2
+        mvi a, -2*3
+        mvi a, ~0F0h&0FFh|80h
+        mvi a, high (base + 100h)
+        mvi a, low -2
+        mvi a, neg+2
+        mvi b, -16>>2
+        lxi h, table + 2*count
+        lxi d, -1
+        lxi b, base/count
+        lxi h, ((va + vb) * (vc - va) + (vb << 2)) & 0FFh
+table:
+        hlt
+        end
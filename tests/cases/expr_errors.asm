@@ -0,0 +1,14 @@
+; each failing expression reports one error, and so does a line past the 
+; token limit
+zero    equ 0
+
+        mvi a, 10/0
+        mvi a, 10/zero
+        mvi a, 10%zero
+        lxi h, 0FFFFh+2
+        mvi a, 1<<20
+        mvi a, 200+zero+100
+        lxi h, (1+2
+        mvi a, 1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1
+        hlt
+        end
@@ -0,0 +1,16 @@
+; flags: -rec5
+; instructions of one, two and three bytes cross the 5 byte records, a 
+; record ends short before each ORG
+        org 0100h
+        lxi h, 2000h
+        mvi a, 55h
+        mov m, a
+        inx h
+        lxi d, 1234h
+        mvi b, 0AAh
+        shld 2100h
+        hlt
+        org 0200h
+        jmp 0100h
+        nop
+        end
@@ -0,0 +1,15 @@
+; two's complement checksums in default 16 byte records, including sums 
+; that leave a checksum of 00h and one below 10h
+        org 0F000h
+        mvi a, 26h
+        mvi b, 00h
+        mvi c, 00h
+        mvi d, 00h
+        mvi e, 00h
+        mvi h, 00h
+        mvi l, 00h
+        nop
+        nop
+        lxi sp, 12FFh
+        jmp 0F000h
+        end
@@ -0,0 +1,12 @@
+; ORG blocks out of address order; outputs follow address order and the 
+; gap between the blocks is not filled
+        org 0210h
+        mvi a, 02h
+        jmp 0100h
+        org 0100h
+        mvi a, 01h
+        jmp 0210h
+        org 0200h
+        nop
+        nop
+        end
@@ -0,0 +1,15 @@
+; code written over earlier code is warned about once per overlapping 
+; stretch and the later code is kept; written bytes count each address once
+        org 0100h
+        lxi h, 1111h
+        lxi d, 2222h
+        lxi b, 3333h
+        org 0101h
+        mvi a, 0AAh
+        mvi b, 0BBh
+        org 0109h
+        nop
+        nop
+        org 0105h
+        xra a
+        end
@@ -0,0 +1,10 @@
+; included lines are assembled in place; messages name the included file 
+; and its own line numbers
+        org 0
+        nop
+        include "include_a.inc"
+        mvi b, value
+        include "include_b.inc"
+        zap
+        hlt
+        end
@@ -0,0 +1,5 @@
+; a file including itself is reported instead of nesting to the depth limit
+        nop
+        include "include_rec.inc"
+        hlt
+        end
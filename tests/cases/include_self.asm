@@ -0,0 +1,5 @@
+; a source including itself is reported at its own INCLUDE line
+        nop
+        include "include_self.asm"
+        hlt
+        end
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2017, Bal Chettri
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or substantial 
+ * portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/** libgat_test.c  assembles sources in memory through libgat and prints the 
+    results for the regression tests. includes are read from the directory 
+    given as the first argument. */
+#include <stdio.h>
+#include <string.h>
+#include "libgat.h"
+
+/* a source of the test */
+typedef struct _libgat_case {
+    const char *name;
+    int flags;
+    int include;                /* sets the include directory before assembling */
+    const char *source;
+}libgat_case;
+
+static const libgat_case s_cases[] = {
+    { "labels.asm", 0, 0, 
+      "value equ 12h\n"
+      "addr  equ 2000h\n"
+      "      org 100h\n"
+      "      mvi a, value\n"
+      "      sta addr\n"
+      "      jmp done\n"
+      "done:\n"
+      "      hlt\n" },
+    { "single.asm", LIBGAT_SINGLE_PASS, 0, 
+      "      jmp next\n"
+      "      mvi a, low -2\n"
+      "next:\n"
+      "      lxi h, next + 1\n" },
+    { "errors.asm", 0, 0, 
+      "      nop\n"
+      "      zap\n"
+      "      jmp nowhere\n" },
+    { "overlap.asm", 0, 0, 
+      "      org 10h\n"
+      "      lxi h, 1234h\n"
+      "      org 11h\n"
+      "      mvi a, 56h\n"
+      "      org 20h\n"
+      "      nop\n" },
+    { "macro.asm", 0, 0, 
+      "store macro addr, val\n"
+      "      mvi a, val\n"
+      "      sta addr\n"
+      "      endm\n"
+      "      org 100h\n"
+      "      store 2000h, 42h\n"
+      "      lxi h, done - 2*3\n"
+      "done:\n"
+      "      hlt\n" },
+    { "noinc.asm", 0, 0, 
+      "      include \"include_a.inc\"\n"
+      "      nop\n" },
+    { "inc.asm", 0, 1, 
+      "      include \"include_a.inc\"\n"
+      "      mvi b, value\n" },
+    { "incerr.asm", 0, 1, 
+      "      nop\n"
+      "      include \"include_b.inc\"\n"
+      "      zap\n" },
+    { "cond.asm", 0, 0, 
+      "      if 0\n"
+      "      if 1\n"
+      "      nop\n"
+      "      endif\n"
+      "      else\n"
+      "      mvi a, 1 << 4 | 2\n"
+      "      endif\n" },
+    { "expr.asm", 0, 0, 
+      "zero  equ 0\n"
+      "      mvi a, 10/zero\n"
+      "      lxi h, 0FFFFh+2\n"
+      "      mvi a, 2*-3\n" }
+};
+
+static const libgat_case s_maxerr = { "maxerr.asm", 0, 0, 
+      "      zap\n"
+      "      zip\n"
+      "      zop\n" };
+
+static void libgat_test_print (const libgat *lg, const libgat_case *c, const libgat_result *r) {
+    unsigned i, start = 0, length;
+
+    printf ("%s: status %d, %u error(s) %u warning(s), %lu bytes\n", c->name, r->status, 
+            r->err_count, r->warn_count, r->size);
+    for (i = 0; i < r->num_diags; i++) {
+        const libgat_diag *d = r->diags + i;
+        printf ("  diag %d %d %s:%u: %s\n", d->kind, d->code, d->file, d->line, d->text);
+    }
+    for (i = 0; i < r->num_symbols; i++) {
+        const libgat_symbol *s = r->symbols + i;
+        printf ("  symbol %s %d %04X\n", s->name, s->kind, s->value);
+    }
+    while (libgat_next_run (lg, &start, &length)) {
+        printf ("  code %04X:", start);
+        for (i = 0; i < length; i++) {
+            printf (" %02X", r->image[start + i]);
+        }
+        printf ("\n");
+        start+= length;
+    }
+}
+
+int main (int argc, char *argv[]) {
+    libgat *lg;
+    libgat_result result;
+    unsigned i;
+
+    if (argc < 2) {
+        printf ("usage: libgat_test <include-dir>\n");
+        return 1;
+    }
+    lg = libgat_create ();
+    if (lg == NULL) {
+        printf ("out of memory\n");
+        return 1;
+    }
+
+    /* one handle assembles all sources, so results must not leak from one 
+       source into the next */
+    printf ("libgat %d\n", libgat_version ());
+    for (i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        const libgat_case *c = s_cases + i;
+
+        libgat_set_include_dir (lg, c->include ? argv[1] : NULL);
+        libgat_assemble (lg, c->name, c->source, strlen (c->source), c->flags, &result);
+        libgat_test_print (lg, c, &result);
+    }
+
+    /* the error limit stops assembly with a fatal error */
+    libgat_set_include_dir (lg, NULL);
+    libgat_set_max_errors (lg, 2);
+    libgat_assemble (lg, s_maxerr.name, s_maxerr.source, strlen (s_maxerr.source), 0, &result);
+    libgat_test_print (lg, &s_maxerr, &result);
+
+    libgat_destroy (lg);
+    return 0;
+}
@@ -0,0 +1,25 @@
+; macro parameters are substituted into the body, also through nested 
+; expansions; an argument may be an expression
+store   macro addr, val
+        mvi a, val
+        sta addr
+        endm
+
+pair    macro first, second, val
+        store first, val
+        store second, val
+        endm
+
+clear   macro reg
+        mvi reg, 0
+        endm
+
+        org 100h
+        store 2000h, 42h
+        clear b
+        clear c
+        lxi h, 3000h
+        pair 2010h, 2011h, 0FFh
+        store 2000h + 2*8, 1 + 2
+        hlt
+        end
@@ -0,0 +1,20 @@
+; macro arguments are runs of tokens between commas; an empty argument, a 
+; trailing comma or a wrong count is an error, and so is a body line that 
+; grows past the token limit
+store   macro addr, val
+        mvi a, val
+        sta addr
+        endm
+
+sum     macro val
+        lxi h, val + val + val + val + val
+        endm
+
+        org 100h
+        store , 42h
+        store 2000h, 42h,
+        store 2000h
+        sum 1+1+1+1+1+1+1+1
+        store 2000h, 42h
+        hlt
+        end
@@ -0,0 +1,9 @@
+; a macro invoking itself stops at the expansion depth limit
+again   macro
+        nop
+        again
+        endm
+
+        again
+        hlt
+        end
@@ -0,0 +1,5 @@
+; a macro definition without ENDM is reported at its MACRO line
+        nop
+open    macro val
+        mvi a, val
+        hlt
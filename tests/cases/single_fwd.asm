@@ -0,0 +1,18 @@
+; forward references to labels and ids resolved at END, in the single pass 
+; engine through fixups
+        org 0400h
+        jmp later
+        lxi h, table
+        mvi a, count
+        call sub
+        jz later
+        hlt
+sub:
+        mvi b, count
+        ret
+table equ 2000h
+count equ 12h
+later:
+        lda table
+        jmp 0400h
+        end